@@ -1,5 +1,13 @@
 #include "schema_io.hpp"
+#include "live_coverage.hpp"
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <glob.h>
+#include <sys/file.h>
+#include <pthread.h>
+#include <glib.h>
 
 extern "C" {
     #include <qemu-plugin.h>
@@ -11,18 +19,267 @@ using namespace std;
 QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
 
 // Table of instructions, which will be converted to capnp format before exit
-unordered_map<int64_t, int8_t> insn_discovered;
-vector<unordered_set<int64_t>> insn_executed;
+// All arrays are indexed by file offset and shared by all vCPUs, so recording an instruction
+// never hashes nor allocates. They are mapped lazily (MAP_NORESERVE), so only pages around
+// translated code are ever backed.
+struct coverage_t {
+    size_t size = 0;                        // file size, i.e. number of valid offsets
+    atomic<uint8_t> * length = nullptr;     // instruction length, 0 if never translated
+    atomic<uint64_t> * executed = nullptr;  // one bit per offset
+    uint64_t * hits = nullptr;              // exec=inline counters or counts=1 totals, one 64-bit slot per offset
+    atomic<uint64_t> * data_read = nullptr; // data=1: one bit per offset of code read as data
+    const uint8_t * image = nullptr;        // verify=1: read-only mapping of the file
+    atomic<uint64_t> * modified = nullptr;  // verify=1: one bit per instruction translated from other bytes
+    live_header_t * live = nullptr;         // live=1: shared memory segment holding executed
+};
 
-// Memory mapping - begin, end, file offset, file name
-unordered_set<string> filename_table;
-typedef tuple<uint64_t, uint64_t, uint64_t, const string *> mapping_t;
-set<mapping_t> mapping_table;
-bool has_mapped = false;
+// mode=2: a translated block, pushed to its module's lock-free list on every translation
+// Offset of the first instruction in the module, number and total length of the instructions in it
+struct tb_record_t {
+    int64_t offset;
+    uint32_t instructions, size;
+    tb_record_t * next;
+};
+
+// A mapped file whose instructions are recorded (the target, or any file with modules=all)
+// Coverage tables are allocated when the first instruction of the file gets translated
+struct module_t {
+    uint32_t id;                // index in modules[]
+    string filename;
+    coverage_t coverage;
+    once_flag alloc_once;
+    atomic<bool> ready { false };
+    // Computed on first use by the checkpoint thread or at exit, started at install for the target
+    string digest;
+    once_flag digest_once;
+    int64_t base_address = -1;
+    // Bits already appended to the checkpoint file, only touched by the checkpoint thread
+    uint64_t * checkpointed = nullptr;
+    // counts=1 and edges=1: execution counts and control-flow edges, gathered at exit
+    capture_details_t details;
+    // mode=2: translated blocks, retranslations included, deduplicated at exit
+    atomic<tb_record_t *> blocks { nullptr };
+    // data=1: file ranges [begin, end) of the executable sections, sorted, set with the coverage tables
+    vector<pair<int64_t, int64_t>> code_ranges;
+    // include= and exclude=: file ranges [begin, end) of the named sections and symbols, sorted
+    vector<pair<int64_t, int64_t>> include_ranges, exclude_ranges;
+};
+// id 0 is never used, so that (id, offset) keys of exec=insn are never null
+#define MAX_MODULES 4096
+atomic<module_t *> modules[MAX_MODULES];
+atomic<uint32_t> n_modules { 1 };
+module_t * target_module = nullptr;
+// Key of exec=insn callbacks: module id in the upper bits, file offset in the lower bits
+#define OFFSET_BITS 40
+
+// Open-addressing set of (source key, target key) pairs, keys as for exec=insn callbacks
+// Keys are never 0, so {0, 0} marks an empty slot. Only touched by its owning vCPU.
+struct edge_set_t {
+    vector<pair<uint64_t, uint64_t>> slots;
+    size_t used = 0;
+};
+
+// Open-addressing map of TB descriptor id + 1 to executions, so that a 0 key marks an empty slot
+// Sized by the TBs its vCPU ran rather than by every descriptor. Only touched by its owning vCPU.
+struct count_map_t {
+    vector<pair<uint64_t, uint64_t>> slots;
+    size_t used = 0;
+};
+
+struct tb_desc_t;
+
+// Per-vCPU state, one cache line each so that vCPU threads never write to a shared line
+// Only ever written by the owning vCPU thread, summed up at exit. The containers are also read
+// before an execve while the other vCPUs keep running: grow_lock is held whenever they reallocate,
+// and by any other thread reading them, so that they never read freed storage.
+struct alignas(64) vcpu_state_t {
+    bool initialized = false;   // set by vcpu_init, the chunk holds states of vCPUs not created yet
+    uint64_t callbacks = 0;     // execution and memory callbacks fired, no-ops included
+    uint64_t discovered = 0;    // instructions first recorded by this vCPU
+    uint64_t syscall_args[6];   // arguments of the pending mapping syscall
+    count_map_t tb_counts;      // counts=1: executions of each TB descriptor this vCPU ran
+    const tb_desc_t * last_tb = nullptr;    // edges=1: previous TB, null once outside recorded modules
+    uint64_t call_return = 0;               // functions=1: address after the call ending the previous TB, or 0
+    edge_set_t edges;                       // edges=1: distinct taken transfers seen by this vCPU
+    uint64_t quiet_insns = 0;               // saturate=: guest instructions run since the last discovery
+    uint64_t seen_discoveries = 0;          // saturate=: value of discoveries when last checked
+    vector<pair<uint64_t, uint64_t>> first_hits;    // timeline=: (instruction key, clock) of each discovery
+    mutex grow_lock;                        // see above, uncontended unless a save is reading
+};
+// vCPU index -> state. QEMU user mode creates one vCPU per guest thread, so there is no upper
+// bound known at install time. Chunks are allocated on vCPU init and never move, so lookups
+// need no lock while the table grows.
+#define VCPU_CHUNK_SIZE 64
+#define VCPU_CHUNKS 1024
+atomic<vcpu_state_t *> vcpu_chunks[VCPU_CHUNKS];
+mutex vcpu_chunks_lock;
+
+// Memory mapping - begin, end, file offset, module
+// A flat array sorted by begin, searched with binary search. It is never modified once published:
+// updates build a new array and swap the pointer, so concurrent translations need no lock.
+// Replaced arrays are retired rather than freed, as another vCPU may still be reading them.
+unordered_map<string, module_t *> module_table;
+struct region_t {
+    uint64_t begin, end, offset;
+    module_t * module;
+};
+typedef vector<region_t> region_table_t;
+atomic<const region_table_t *> region_table { nullptr };
+vector<unique_ptr<const region_table_t>> retired_tables;
+mutex region_lock;
+// Several vCPU threads may translate concurrently (MTTCG), the first one builds the table
+once_flag mapping_once;
+// Last region hit by this thread, valid as long as the table it came from is current
+thread_local const region_table_t * last_table = nullptr;
+thread_local const region_t * last_region = nullptr;
+
+// Guest syscalls that change the memory mapping, -1 when unknown for the target
+struct mapping_syscalls_t {
+    int64_t mmap = -1, munmap = -1, mremap = -1;
+};
+mapping_syscalls_t mapping_syscalls;
+// Guest syscalls that replace the process image, the capture is saved before they run
+struct exec_syscalls_t {
+    int64_t execve = -1, execveat = -1;
+};
+exec_syscalls_t exec_syscalls;
 
 const string * target_filename = nullptr;
 int output_version = 0;
+// mode=2: also record every translated block, executed or not
+int output_mode = 0;
+// modules=all: record every file-backed mapping, not only the target
+bool all_modules = false;
+// counts=1: also record how many times each instruction was executed
+bool record_counts = false;
+// edges=1: also record taken control transfers between TBs
+bool record_edges = false;
+// functions=1: also record call targets as function starts
+bool record_functions = false;
+// data=1: also record loads from executable sections (jump tables, literal pools)
+bool record_data = false;
+// verify=1: compare translated instructions with the file, to flag self-modifying or unpacked code
+bool verify_code = false;
+// live=1: the executed bitsets live in POSIX shared memory, so that live_coverage can read them
+// while the guest runs. A segment is named after the process that created it, which is also
+// recorded in its header, and only that process removes it. A forked child copies the segments
+// it inherited into its own, as its length tables are private copies as well.
+bool live_export = false;
+// extents=1: store the instructions of version 1 outputs as runs of contiguous instructions
+bool write_extents = false;
+// include= and exclude=: sections (e.g. .text) and symbols whose instructions are (not) recorded
+// Resolved against every recorded file when its coverage tables are set up, and applied at
+// translation time, so filtered instructions get no callback at all
+unordered_set<string> include_names, exclude_names;
+// timeline=: also record when each instruction was first executed, in guest instructions run so far
+// (counted per TB by an inline add, which may lose a few updates across vCPUs) or in nanoseconds
+// since install. Each vCPU appends to its own list on discovery, sorted by clock at save time.
+enum timeline_clock_t { TIMELINE_NONE, TIMELINE_INSNS, TIMELINE_TIME };
+timeline_clock_t timeline_clock = TIMELINE_NONE;
+// Bumped by the generated code of every vCPU, which QEMU 7.2 only lets add to a fixed address.
+// Alignment pads it to a cache line of its own, so these adds do not evict globals read nearby.
+struct alignas(64) guest_insns_t {
+    uint64_t value = 0;
+} guest_insns;
+uint64_t timeline_start = 0;
+
+// Self-instrumentation, reported after each save to capnp-capture.log and as one JSON object per
+// line in capnp-capture.stats.jsonl. Translation-time counters are shared relaxed atomics, which
+// only cost at translation. Execution-time ones stay per vCPU (vcpu_state_t::callbacks, discovered).
+struct plugin_stats_t {
+    atomic<uint64_t> tbs_translated { 0 };
+    atomic<uint64_t> tbs_rejected { 0 };       // outside the span of the recorded mappings
+    atomic<uint64_t> insns_translated { 0 };
+    atomic<uint64_t> insns_instrumented { 0 }; // recorded instructions, with a callback or inline add
+    atomic<uint64_t> lookups { 0 };            // resolve_mapping calls
+    atomic<uint64_t> lookup_misses { 0 };      // lookups that missed the last region and searched the table
+    atomic<uint64_t> unresolved { 0 };         // lookups outside any recorded file
+    // Wall-clock time of the phases of the last save, in nanoseconds, summed over modules
+    // Merging with the old output reads and writes in one pass, counted as write
+    uint64_t gather_ns = 0, collect_ns = 0, digest_ns = 0, segment_ns = 0, merge_ns = 0, read_old_ns = 0, write_ns = 0;
+};
+plugin_stats_t stats;
+// functions=1: recognises a call instruction of the guest ISA from its bytes, set from target_name
+bool (*is_call)(const uint8_t * bytes, size_t size) = nullptr;
 ofstream logger;
+// Guards logger outside of install and exit, when vCPU or checkpoint threads may log concurrently
+mutex log_lock;
+
+// Checkpoints (checkpoint=<seconds>, checkpoint_signal=1): a background thread appends the
+// instructions recorded since the previous checkpoint to <output>.<pid>.ckpt while the guest
+// keeps running. plugin_exit folds the file into the output and removes it; files left behind by
+// runs that never reached their exit are merged by the next run of the same binary.
+unsigned checkpoint_interval = 0;
+bool checkpoint_on_signal = false;
+thread checkpoint_thread;
+sem_t checkpoint_sem;
+atomic<bool> checkpoint_stop { false };
+once_flag signal_once;
+// Serialises saving the capture (exit, execve) with the checkpoint thread
+mutex save_lock;
+
+// Saving never waits for other processes, be they forked children or parallel runs of the same
+// binary. Every save publishes an immutable segment <output>.<pid>.<time>.seg (written to a .tmp
+// file, then renamed), and whichever process gets the flock on <output>.lock without waiting
+// compacts all segments into the output. The others leave theirs to it.
+// A forked child inherits the recorded state, minus the counts, which the parent saves itself.
+
+// How executed instructions are observed (exec=)
+//   insn: one callback per instruction (default)
+//   tb:   one callback per translation block, carrying a precomputed descriptor
+//   inline: no callback at all, an inline add bumps the instruction's slot in coverage.hits
+//   once: like tb, but TBs whose instructions are all recorded lose their callback on retranslation
+enum exec_mode_t { EXEC_INSN, EXEC_TB, EXEC_INLINE, EXEC_ONCE };
+exec_mode_t exec_mode = EXEC_INSN;
+
+// Per-TB descriptor for exec=tb: file offsets of all in-target instructions of the TB
+// Built once at translation time, so that a TB execution costs one callback
+// A TB never runs across two files in practice, instructions of a second module are ignored
+struct tb_desc_t {
+    uint32_t id;
+    module_t * module;
+    vector<int64_t> offsets;
+    // edges=1: offset of the first instruction (-1 if the TB starts outside the module),
+    // of the last one, and right after the last one (where falling through would lead)
+    int64_t entry = -1, last = -1, end = -1;
+    // functions=1: guest address of the TB, and after the last instruction if it is a call, else 0
+    uint64_t vaddr = 0, call_return = 0;
+    // functions=1: set once the TB was entered right after a call
+    atomic<bool> called { false };
+    // exec=once: set after the first execution, the callback is a no-op from then on
+    atomic<bool> recorded { false };
+    tb_desc_t * next = nullptr;
+};
+// Lock-free list owning every descriptor handed to QEMU as callback userdata, freed at exit
+atomic<tb_desc_t *> tb_descs { nullptr };
+atomic<uint32_t> n_tb_descs { 0 };
+
+// Binary digest (digest=), computed over an mmap of the file
+//   md5:   same as md5sum, compatible with captures taken by earlier versions (default)
+//   xxh64: several times faster on large binaries, stored with the digestAlgorithm field
+// The target's digest is computed on a background thread started at install, overlapping the emulation
+enum digest_algorithm_t { DIGEST_MD5, DIGEST_XXH64 };
+digest_algorithm_t digest_algorithm = DIGEST_MD5;
+thread digest_thread;
+
+// exec=once: QEMU 7.2 has no conditional callbacks, so instead we flush the TB cache once
+// enough TBs went quiet. Retranslated TBs that are fully recorded get no callback at all.
+// The threshold doubles after each flush to bound the number of flushes.
+qemu_plugin_id_t plugin_id;
+atomic<uint64_t> quiet_threshold { 1024 };
+atomic<uint64_t> quiet_tbs { 0 };
+atomic<bool> flush_pending { false };
+
+// Saturation (saturate=<N>): coverage of long runs stops growing early, so once no vCPU recorded a
+// new instruction while a vCPU ran N guest instructions, the capture is saved and the plugin drops
+// all its callbacks. QEMU then runs at bare TCG speed until the guest exits, or is terminated
+// right away with saturate_exit=1.
+// qemu_plugin_reset is used rather than qemu_plugin_uninstall, which unloads the plugin while the
+// pthread_atfork handlers still point into it.
+uint64_t saturate_insns = 0;
+bool saturate_exit = false;
+atomic<uint64_t> discoveries { 0 };
+atomic<bool> saturated { false };
 
 // Ref: https://stackoverflow.com/questions/12774207/fastest-way-to-check-if-a-file-exists-using-standard-c-c11-14-17-c
 inline bool file_exists(const string& name) {
@@ -30,258 +287,2145 @@ inline bool file_exists(const string& name) {
     return (stat (name.c_str(), &buffer) == 0); 
 }
 
-// Ref: https://stackoverflow.com/questions/478898/how-do-i-execute-a-command-and-get-the-output-of-the-command-within-c-using-po
-string exec(const char* cmd) {
-    array<char, 128> buffer;
-    string result;
-    unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd, "r"), pclose);
-    if (!pipe) {
-        throw runtime_error("popen() failed!");
-    }
-    while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-        result += buffer.data();
+
+// Ref: https://dev.to/namantam1/ways-to-get-the-file-size-in-c-2mag
+int64_t get_file_size(const char *filename) {
+    struct stat file_status;
+    if (stat(filename, &file_status) < 0) {
+        return -1;
+    }
+    return file_status.st_size;
+}
+
+// Zero-filled memory whose pages only get backed once touched
+// Takes log_lock on failure, so it must not be held
+static void * alloc_lazy(size_t bytes)
+{
+    void * mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem == MAP_FAILED) {
+        lock_guard<mutex> guard(log_lock);
+        logger << "Unable to allocate " << bytes << " bytes: " << strerror(errno) << endl;
+        return nullptr;
+    }
+    return mem;
+}
+
+static int64_t parse_base_address(const string & filename, vector<pair<int64_t, int64_t>> * code_ranges);
+
+// live=1: header and executed bitset of the module in a new shared memory segment
+// Pages of the segment are only backed once touched, like those of alloc_lazy
+// Takes log_lock on failure, so it must not be held
+static live_header_t * alloc_live(const module_t * module, size_t size)
+{
+    string name = live_coverage_name(getpid(), module->id);
+    size_t bytes = sizeof(live_header_t) + (size + 63) / 64 * sizeof(uint64_t);
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd == -1) {
+        lock_guard<mutex> guard(log_lock);
+        logger << "Unable to create " << name << ": " << strerror(errno) << endl;
+        return nullptr;
+    }
+    void * mem = ftruncate(fd, bytes) == -1 ? MAP_FAILED : mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        lock_guard<mutex> guard(log_lock);
+        logger << "Unable to map " << name << ": " << strerror(errno) << endl;
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+    live_header_t * live = (live_header_t *) mem;
+    live->size = size;
+    live->pid = getpid();
+    strncpy(live->filename, module->filename.c_str(), sizeof(live->filename) - 1);
+    __atomic_store_n(&live->magic, LIVE_COVERAGE_MAGIC, __ATOMIC_RELEASE);
+    return live;
+}
+
+static bool is_elf(const string & filename)
+{
+    char magic[SELFMAG];
+    int fd = open(filename.c_str(), O_RDONLY);
+    bool elf = fd != -1 && read(fd, magic, SELFMAG) == SELFMAG && !memcmp(magic, ELFMAG, SELFMAG);
+    if (fd != -1) {
+        close(fd);
+    }
+    return elf;
+}
+
+// Name at index in a string table section, or null if the table or the name lies outside the image
+template <typename Shdr>
+static const char * elf_string(const uint8_t * image, size_t size, const Shdr & table, uint64_t index)
+{
+    if (table.sh_offset > size || table.sh_size > size - table.sh_offset || index >= table.sh_size) {
+        return nullptr;
+    }
+    const char * name = (const char *) image + table.sh_offset + index;
+    return memchr(name, 0, table.sh_size - index) ? name : nullptr;
+}
+
+// File ranges of the sections and defined symbols of an ELF image whose name is in names
+// The image may be truncated or corrupt, so every table is checked against its size
+template <typename Ehdr, typename Shdr, typename Sym>
+static void find_named_ranges(const uint8_t * image, size_t size, const unordered_set<string> & names,
+                              vector<pair<int64_t, int64_t>> & ranges)
+{
+    const Ehdr * eh = (const Ehdr *) image;
+    if (size < sizeof(Ehdr) || eh->e_shoff > size || (uint64_t) eh->e_shnum * sizeof(Shdr) > size - eh->e_shoff
+        || eh->e_shstrndx >= eh->e_shnum) {
+        return;
+    }
+    const Shdr * sh_tbl = (const Shdr *) (image + eh->e_shoff);
+    for (int i = 0; i < eh->e_shnum; ++i) {
+        const Shdr & section = sh_tbl[i];
+        const char * section_name = elf_string(image, size, sh_tbl[eh->e_shstrndx], section.sh_name);
+        if (section.sh_type != SHT_NOBITS && section_name && names.count(section_name)) {
+            ranges.emplace_back(section.sh_offset, section.sh_offset + section.sh_size);
+        }
+        if ((section.sh_type != SHT_SYMTAB && section.sh_type != SHT_DYNSYM) || section.sh_link >= eh->e_shnum
+            || section.sh_offset > size || section.sh_size > size - section.sh_offset) {
+            continue;
+        }
+        const Sym * symbols = (const Sym *) (image + section.sh_offset);
+        for (size_t s = 0; s < section.sh_size / sizeof(Sym); ++s) {
+            const Sym & symbol = symbols[s];
+            if (!symbol.st_size || symbol.st_shndx == SHN_UNDEF || symbol.st_shndx >= eh->e_shnum) {
+                continue;
+            }
+            const char * symbol_name = elf_string(image, size, sh_tbl[section.sh_link], symbol.st_name);
+            if (!symbol_name || !names.count(symbol_name)) {
+                continue;
+            }
+            // Symbol values are addresses, their section tells where they lie in the file
+            const Shdr & home = sh_tbl[symbol.st_shndx];
+            int64_t begin = symbol.st_value - home.sh_addr + home.sh_offset;
+            ranges.emplace_back(begin, begin + symbol.st_size);
+        }
+    }
+}
+
+// include= and exclude=: resolves the names in the file, the ranges are sorted and coalesced
+static void parse_filter_ranges(module_t * module, size_t size)
+{
+    int fd = open(module->filename.c_str(), O_RDONLY);
+    void * image = fd == -1 ? MAP_FAILED : mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (fd != -1) {
+        close(fd);
+    }
+    if (image == MAP_FAILED) {
+        return;
+    }
+    const uint8_t * bytes = (const uint8_t *) image;
+    bool elf64 = bytes[EI_CLASS] == ELFCLASS64;
+    for (auto [names, ranges] : { make_pair(&include_names, &module->include_ranges),
+                                  make_pair(&exclude_names, &module->exclude_ranges) }) {
+        if (names->empty()) {
+            continue;
+        }
+        if (elf64 && size >= sizeof(Elf64_Ehdr)) {
+            find_named_ranges<Elf64_Ehdr, Elf64_Shdr, Elf64_Sym>(bytes, size, *names, *ranges);
+        } else if (!elf64 && size >= sizeof(Elf32_Ehdr)) {
+            find_named_ranges<Elf32_Ehdr, Elf32_Shdr, Elf32_Sym>(bytes, size, *names, *ranges);
+        }
+        // A symbol may lie in a section listed too, or be aliased by another one
+        sort(ranges->begin(), ranges->end());
+        vector<pair<int64_t, int64_t>> coalesced;
+        for (const auto & range : *ranges) {
+            if (!coalesced.empty() && range.first <= coalesced.back().second) {
+                coalesced.back().second = max(coalesced.back().second, range.second);
+            } else {
+                coalesced.push_back(range);
+            }
+        }
+        ranges->swap(coalesced);
+    }
+    munmap(image, size);
+    
+    lock_guard<mutex> guard(log_lock);
+    logger << "Filters on " << module->filename << ": " << module->include_ranges.size() << " included and "
+           << module->exclude_ranges.size() << " excluded ranges" << endl;
+}
+
+// On failure size stays 0, so that nothing ever resolves into the module
+static void alloc_coverage(module_t * module)
+{
+    coverage_t & coverage = module->coverage;
+    int64_t size = get_file_size(module->filename.c_str());
+    if (size > 0) {
+        coverage.length = (atomic<uint8_t> *) alloc_lazy(size);
+        if (live_export) {
+            coverage.live = alloc_live(module, size);
+            coverage.executed = coverage.live ? (atomic<uint64_t> *) (coverage.live + 1) : nullptr;
+        } else {
+            coverage.executed = (atomic<uint64_t> *) alloc_lazy((size + 63) / 64 * sizeof(uint64_t));
+        }
+        // Allocated upfront even for exec=tb, as the save path must not allocate under log_lock
+        if (exec_mode == EXEC_INLINE || record_counts) {
+            coverage.hits = (uint64_t *) alloc_lazy(size * sizeof(uint64_t));
+        }
+        if (verify_code) {
+            coverage.modified = (atomic<uint64_t> *) alloc_lazy((size + 63) / 64 * sizeof(uint64_t));
+            int fd = open(module->filename.c_str(), O_RDONLY);
+            void * image = fd == -1 ? MAP_FAILED : mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (image != MAP_FAILED) {
+                coverage.image = (const uint8_t *) image;
+            }
+            if (fd != -1) {
+                close(fd);
+            }
+        }
+        if (record_data) {
+            coverage.data_read = (atomic<uint64_t> *) alloc_lazy((size + 63) / 64 * sizeof(uint64_t));
+            // Files without executable sections (or not ELF at all) never record data reads
+            if (is_elf(module->filename)) {
+                lock_guard<mutex> guard(log_lock);
+                module->base_address = parse_base_address(module->filename, &module->code_ranges);
+            }
+        }
+        if ((!include_names.empty() || !exclude_names.empty()) && is_elf(module->filename)) {
+            parse_filter_ranges(module, size);
+        }
+    }
+    if (coverage.length && coverage.executed && ((exec_mode != EXEC_INLINE && !record_counts) || coverage.hits)
+        && (!record_data || coverage.data_read) && (!verify_code || (coverage.modified && coverage.image))) {
+        coverage.size = size;
+    } else {
+        lock_guard<mutex> guard(log_lock);
+        logger << "Unable to set up coverage tables for " << module->filename << endl;
+    }
+    module->ready.store(true, memory_order_release);
+}
+
+static inline coverage_t & get_coverage(module_t * module)
+{
+    if (!module->ready.load(memory_order_acquire)) {
+        call_once(module->alloc_once, alloc_coverage, module);
+    }
+    return module->coverage;
+}
+
+static void free_coverage(coverage_t & coverage)
+{
+    if (coverage.length) {
+        munmap(coverage.length, coverage.size);
+    }
+    if (coverage.live) {
+        munmap(coverage.live, sizeof(live_header_t) + (coverage.size + 63) / 64 * sizeof(uint64_t));
+    } else if (coverage.executed) {
+        munmap(coverage.executed, (coverage.size + 63) / 64 * sizeof(uint64_t));
+    }
+    if (coverage.hits) {
+        munmap(coverage.hits, coverage.size * sizeof(uint64_t));
+    }
+    if (coverage.data_read) {
+        munmap(coverage.data_read, (coverage.size + 63) / 64 * sizeof(uint64_t));
+    }
+    if (coverage.modified) {
+        munmap(coverage.modified, (coverage.size + 63) / 64 * sizeof(uint64_t));
+    }
+    if (coverage.image) {
+        munmap((void *) coverage.image, coverage.size);
+    }
+    coverage = coverage_t();
+}
+
+// Requires region_lock
+static module_t * get_module(const string & filename)
+{
+    auto it = module_table.find(filename);
+    if (it != module_table.end()) {
+        return it->second;
+    }
+    uint32_t id = n_modules.load(memory_order_relaxed);
+    if (id == MAX_MODULES) {
+        return nullptr;
+    }
+    module_t * module = new module_t;
+    module->id = id;
+    module->filename = filename;
+    modules[id].store(module, memory_order_release);
+    n_modules.store(id + 1, memory_order_release);
+    module_table.emplace(filename, module);
+    return module;
+}
+
+// live=1: moves the executed bitsets inherited from the parent into segments of this process
+// Runs in a forked child, where no other thread can touch the bitsets
+static void fork_live()
+{
+    for (uint32_t id = 1; id < n_modules.load(memory_order_acquire); ++id) {
+        module_t * module = modules[id].load(memory_order_acquire);
+        coverage_t & coverage = module->coverage;
+        if (!module->ready.load(memory_order_acquire) || !coverage.live) {
+            continue;
+        }
+        size_t words = (coverage.size + 63) / 64;
+        live_header_t * live = alloc_live(module, coverage.size);
+        // Without a segment the child keeps recording into private memory, unpublished
+        void * executed = live ? (void *) (live + 1) : alloc_lazy(words * sizeof(uint64_t));
+        if (!executed) {
+            continue;
+        }
+        memcpy(executed, coverage.executed, words * sizeof(uint64_t));
+        munmap(coverage.live, sizeof(live_header_t) + words * sizeof(uint64_t));
+        coverage.live = live;
+        coverage.executed = (atomic<uint64_t> *) executed;
+    }
+}
+
+// live=1: removes the names of the segments, their mappings stay valid
+static void unlink_live()
+{
+    for (uint32_t id = 1; id < n_modules.load(memory_order_acquire); ++id) {
+        module_t * module = modules[id].load(memory_order_acquire);
+        const live_header_t * live = module->coverage.live;
+        if (module->ready.load(memory_order_acquire) && live && live->pid == getpid()) {
+            shm_unlink(live_coverage_name(live->pid, module->id).c_str());
+        }
+    }
+}
+
+static void free_modules()
+{
+    for (uint32_t id = 1; id < n_modules; ++id) {
+        module_t * module = modules[id].exchange(nullptr);
+        if (module->checkpointed) {
+            munmap(module->checkpointed, (module->coverage.size + 63) / 64 * sizeof(uint64_t));
+        }
+        free_coverage(module->coverage);
+        for (tb_record_t * block = module->blocks.exchange(nullptr); block; ) {
+            tb_record_t * next = block->next;
+            delete block;
+            block = next;
+        }
+        delete module;
+    }
+    n_modules = 1;
+    module_table.clear();
+}
+
+static inline uint64_t insn_key(const module_t * module, int64_t offset)
+{
+    return ((uint64_t) module->id << OFFSET_BITS) | offset;
+}
+
+static inline bool is_wanted(const string & filename)
+{
+    return all_modules ? !filename.empty() : filename == *target_filename;
+}
+
+// Returns true if this call is the one that recorded the instruction
+static inline bool mark_executed(coverage_t & coverage, int64_t offset)
+{
+    atomic<uint64_t> & word = coverage.executed[offset / 64];
+    uint64_t bit = 1ull << (offset % 64);
+    // Plain load first, so that re-executions only ever read the shared cache line
+    if (word.load(memory_order_relaxed) & bit) {
+        return false;
+    }
+    return !(word.fetch_or(bit, memory_order_relaxed) & bit);
+}
+
+static inline uint64_t monotonic_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+// timeline=: clock value recorded with a first execution
+static inline uint64_t timeline_now()
+{
+    return timeline_clock == TIMELINE_INSNS ? guest_insns.value : monotonic_ns() - timeline_start;
+}
+
+static inline bool is_executed(const coverage_t & coverage, int64_t offset)
+{
+    return coverage.executed[offset / 64].load(memory_order_relaxed) & (1ull << (offset % 64));
+}
+
+static vcpu_state_t * alloc_vcpu_chunk(size_t chunk)
+{
+    lock_guard<mutex> guard(vcpu_chunks_lock);
+    vcpu_state_t * states = vcpu_chunks[chunk].load(memory_order_relaxed);
+    if (!states) {
+        states = new vcpu_state_t[VCPU_CHUNK_SIZE];
+        vcpu_chunks[chunk].store(states, memory_order_release);
+    }
+    return states;
+}
+
+// Indexes beyond VCPU_CHUNK_SIZE * VCPU_CHUNKS wrap around and share a state (counts stay approximate)
+static inline vcpu_state_t & get_vcpu(unsigned int vcpu_index)
+{
+    size_t chunk = vcpu_index / VCPU_CHUNK_SIZE % VCPU_CHUNKS;
+    vcpu_state_t * states = vcpu_chunks[chunk].load(memory_order_acquire);
+    if (!states) {
+        states = alloc_vcpu_chunk(chunk);
+    }
+    return states[vcpu_index % VCPU_CHUNK_SIZE];
+}
+
+static void vcpu_init(qemu_plugin_id_t id, unsigned int vcpu_index)
+{
+    get_vcpu(vcpu_index).initialized = true;
+}
+
+static void free_vcpus()
+{
+    for (atomic<vcpu_state_t *> & chunk : vcpu_chunks) {
+        delete[] chunk.exchange(nullptr);
+    }
+}
+
+// We *NOT ONLY* care about segments with x permission
+// Note that original file is mapped with non-executable permission
+// Also to ignore all files that does not match the filename (unless modules=all)
+// Requires region_lock
+static void update_mapping(region_table_t & table)
+{
+    FILE * m = fopen("/proc/self/maps", "r");
+    if (!m) {
+        lock_guard<mutex> guard(log_lock);
+        logger << "Unable to read /proc/self/maps: " << strerror(errno) << endl;
+        return;
+    }
+    
+    char line[4096];
+    uint64_t begin, end, offset, inode;
+    int path_start;
+    
+    table.clear();
+    while (fgets(line, sizeof(line), m)) {
+        if (sscanf(line, "%" SCNx64 "-%" SCNx64 " %*s %" SCNx64 " %*s %" SCNu64 " %n",
+                   &begin, &end, &offset, &inode, &path_start) != 4 || inode == 0) {
+            continue;
+        }
+        char * filename = line + path_start;
+        filename[strcspn(filename, "\n")] = 0;
+        
+        if (!is_wanted(filename)) {
+            continue;
+        }
+        module_t * module = get_module(filename);
+        if (module) {
+            table.push_back({ begin, end, offset, module });
+        }
+    }
+    fclose(m);
+    
+    // /proc/<pid>/maps is already sorted by address
+}
+
+// Requires region_lock
+static void publish_mapping(region_table_t * table)
+{
+    const region_table_t * old = region_table.exchange(table, memory_order_release);
+    if (old) {
+        retired_tables.emplace_back(old);
+    }
+}
+
+static void init_mapping()
+{
+    lock_guard<mutex> guard(region_lock);
+    region_table_t * table = new region_table_t;
+    update_mapping(*table);
+    publish_mapping(table);
+}
+
+// Cut [begin, end) out of the table, keeping the parts of regions around it
+static void unmap_range(region_table_t & table, uint64_t begin, uint64_t end)
+{
+    region_table_t result;
+    for (const region_t & region : table) {
+        if (region.end <= begin || region.begin >= end) {
+            result.push_back(region);
+            continue;
+        }
+        if (region.begin < begin) {
+            result.push_back({ region.begin, begin, region.offset, region.module });
+        }
+        if (region.end > end) {
+            result.push_back({ end, region.end, region.offset + (end - region.begin), region.module });
+        }
+    }
+    table.swap(result);
+}
+
+static bool overlaps_mapping(uint64_t begin, uint64_t end)
+{
+    const region_table_t * table = region_table.load(memory_order_acquire);
+    if (!table) {
+        return false;
+    }
+    for (const region_t & region : *table) {
+        if (region.begin < end && begin < region.end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void save_capture();
+static void reset_counts();
+
+/*
+ * Syscall hooks keeping the table in sync with mappings created after the first translation
+ * (dlopen, late mmap of the target). mmap/munmap are applied incrementally, mremap is rare
+ * and simply re-reads /proc/self/maps. mprotect is not tracked: it cannot change which file
+ * offset sits at an address.
+ *
+ * A successful execve never returns and plugin_exit does not run for the old image, so the
+ * capture is saved on entry. If the execve fails the guest goes on, and saving again at exit
+ * is harmless as the counts saved here were reset.
+ */
+static void vcpu_syscall(qemu_plugin_id_t id, unsigned int vcpu_index, int64_t num,
+                         uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4,
+                         uint64_t a5, uint64_t a6, uint64_t a7, uint64_t a8)
+{
+    if (num == exec_syscalls.execve || num == exec_syscalls.execveat) {
+        save_capture();
+        reset_counts();
+        // Nobody would remove the segments after the image is replaced
+        unlink_live();
+        return;
+    }
+    if (num == mapping_syscalls.mmap || num == mapping_syscalls.munmap || num == mapping_syscalls.mremap) {
+        uint64_t * args = get_vcpu(vcpu_index).syscall_args;
+        args[0] = a1; args[1] = a2; args[2] = a3;
+        args[3] = a4; args[4] = a5; args[5] = a6;
+    }
+}
+
+static void vcpu_syscall_ret(qemu_plugin_id_t id, unsigned int vcpu_index, int64_t num, int64_t ret)
+{
+    if (ret < 0 && ret > -4096) {
+        return;
+    }
+    if (num != mapping_syscalls.mmap && num != mapping_syscalls.munmap && num != mapping_syscalls.mremap) {
+        return;
+    }
+    call_once(mapping_once, init_mapping);
+    const uint64_t * args = get_vcpu(vcpu_index).syscall_args;
+    
+    if (num == mapping_syscalls.mmap) {
+        // mmap(addr, length, prot, flags, fd, offset)
+        uint64_t begin = ret, end = ret + args[1];
+        bool anonymous = (args[3] & MAP_ANONYMOUS) || (int) args[4] < 0;
+        string filename;
+        if (!anonymous) {
+            char link[64], path[4096];
+            snprintf(link, sizeof(link), "/proc/self/fd/%d", (int) args[4]);
+            ssize_t n = readlink(link, path, sizeof(path) - 1);
+            if (n > 0) {
+                filename.assign(path, n);
+            }
+        }
+        bool wanted = is_wanted(filename);
+        // A fresh anonymous mapping cannot overlap anything unless it was placed with MAP_FIXED
+        if (!wanted && !overlaps_mapping(begin, end)) {
+            return;
+        }
+        
+        lock_guard<mutex> guard(region_lock);
+        region_table_t * table = new region_table_t(*region_table.load(memory_order_relaxed));
+        unmap_range(*table, begin, end);
+        module_t * module = wanted ? get_module(filename) : nullptr;
+        if (module) {
+            region_t region { begin, end, args[5], module };
+            table->insert(upper_bound(table->begin(), table->end(), region,
+                [](const region_t & a, const region_t & b) { return a.begin < b.begin; }), region);
+        }
+        publish_mapping(table);
+    } else if (num == mapping_syscalls.munmap) {
+        // munmap(addr, length)
+        if (!overlaps_mapping(args[0], args[0] + args[1])) {
+            return;
+        }
+        lock_guard<mutex> guard(region_lock);
+        region_table_t * table = new region_table_t(*region_table.load(memory_order_relaxed));
+        unmap_range(*table, args[0], args[0] + args[1]);
+        publish_mapping(table);
+    } else if (num == mapping_syscalls.mremap) {
+        lock_guard<mutex> guard(region_lock);
+        region_table_t * table = new region_table_t;
+        update_mapping(*table);
+        publish_mapping(table);
+    }
+}
+
+// Whether offset lies in one of ranges, sorted and disjoint [begin, end) pairs
+static inline bool in_ranges(const vector<pair<int64_t, int64_t>> & ranges, int64_t offset)
+{
+    auto range = upper_bound(ranges.begin(), ranges.end(), make_pair(offset, INT64_MAX));
+    return range != ranges.begin() && offset < (range - 1)->second;
+}
+
+// include= and exclude=: only called at translation time
+static inline bool is_filtered_out(const module_t * module, int64_t offset)
+{
+    return (!include_names.empty() && !in_ranges(module->include_ranges, offset))
+        || in_ranges(module->exclude_ranges, offset);
+}
+
+// Whether the guest range [begin, end) lies outside the span of all recorded mappings, in which
+// case none of its instructions can resolve. With modules=target this rejects the TBs of libc and
+// the dynamic loader at once.
+static bool outside_regions(uint64_t begin, uint64_t end)
+{
+    call_once(mapping_once, init_mapping);
+    const region_table_t * table = region_table.load(memory_order_acquire);
+    return table->empty() || end <= table->front().begin || begin >= table->back().end;
+}
+
+/*
+ * Inputs virtual address, outputs offset and the module it belongs to
+ * Offsets past the end of the file (tail of the last mapped page) are not resolved
+ *
+ * Consecutive instructions almost always fall into the same region, so the last hit is
+ * checked before the binary search
+ */
+static int64_t resolve_mapping(uint64_t vaddr, module_t *& module)
+{
+    call_once(mapping_once, init_mapping);
+    const region_table_t * table = region_table.load(memory_order_acquire);
+    
+    const region_t * region = nullptr;
+    stats.lookups.fetch_add(1, memory_order_relaxed);
+    if (last_table == table && last_region && last_region->begin <= vaddr && vaddr < last_region->end) {
+        region = last_region;
+    } else {
+        stats.lookup_misses.fetch_add(1, memory_order_relaxed);
+        // First region starting after vaddr, the candidate is the one before it
+        auto it = upper_bound(table->begin(), table->end(), vaddr,
+            [](uint64_t addr, const region_t & r) { return addr < r.begin; });
+        if (it == table->begin() || vaddr >= (it - 1)->end) {
+            stats.unresolved.fetch_add(1, memory_order_relaxed);
+            return -1;
+        }
+        region = &*(it - 1);
+        last_table = table;
+        last_region = region;
+    }
+    
+    // now: begin <= vaddr < end
+    // vaddr - begin + base
+    module = region->module;
+    int64_t offset = vaddr - region->begin + region->offset;
+    return (size_t) offset < get_coverage(module).size ? offset : -1;
+}
+
+// timeline=: appends a first execution, reserving room under grow_lock so that it never
+// reallocates while another thread reads the list
+static inline void record_first_hit(vcpu_state_t & vcpu, uint64_t key)
+{
+    vector<pair<uint64_t, uint64_t>> & first_hits = vcpu.first_hits;
+    if (first_hits.size() == first_hits.capacity()) {
+        lock_guard<mutex> guard(vcpu.grow_lock);
+        first_hits.reserve(max<size_t>(1024, first_hits.capacity() * 2));
+    }
+    first_hits.emplace_back(key, timeline_now());
+}
+
+// Only registered on recorded instructions, userdata is their (module, offset) key
+static void vcpu_insn_exec(unsigned int vcpu_index, void *userdata)
+{
+    uint64_t key = (uint64_t) userdata;
+    module_t * module = modules[key >> OFFSET_BITS].load(memory_order_relaxed);
+    vcpu_state_t & vcpu = get_vcpu(vcpu_index);
+    ++vcpu.callbacks;
+    if (mark_executed(module->coverage, key & ((1ull << OFFSET_BITS) - 1))) {
+        ++vcpu.discovered;
+        if (timeline_clock != TIMELINE_NONE) {
+            record_first_hit(vcpu, key);
+        }
+        if (saturate_insns) {
+            discoveries.fetch_add(1, memory_order_relaxed);
+        }
+    }
+}
+
+// Marks the instructions of a TB, the caller counts the callback
+static void record_tb(vcpu_state_t & vcpu, const tb_desc_t * desc)
+{
+    coverage_t & coverage = desc->module->coverage;
+    uint64_t found = 0;
+    for (int64_t offset : desc->offsets) {
+        if (mark_executed(coverage, offset)) {
+            if (timeline_clock != TIMELINE_NONE) {
+                record_first_hit(vcpu, insn_key(desc->module, offset));
+            }
+            ++found;
+        }
+    }
+    if (found) {
+        vcpu.discovered += found;
+        if (saturate_insns) {
+            discoveries.fetch_add(found, memory_order_relaxed);
+        }
+    }
+}
+
+static void vcpu_tb_exec(unsigned int vcpu_index, void *userdata)
+{
+    vcpu_state_t & vcpu = get_vcpu(vcpu_index);
+    ++vcpu.callbacks;
+    record_tb(vcpu, (const tb_desc_t *) userdata);
+}
+
+/*
+ * data=1: a guest load, recorded if it reads an executable section of a recorded module
+ * Most loads hit the stack or the heap, which lie outside the span of the recorded files or
+ * between them, so the bounds of the table and a binary search reject them without any write
+ */
+static void vcpu_mem_read(unsigned int vcpu_index, qemu_plugin_meminfo_t info, uint64_t vaddr, void *userdata)
+{
+    ++get_vcpu(vcpu_index).callbacks;
+    const region_table_t * table = region_table.load(memory_order_acquire);
+    if (!table || table->empty() || vaddr < table->front().begin || vaddr >= table->back().end) {
+        return;
+    }
+    auto it = upper_bound(table->begin(), table->end(), vaddr,
+        [](uint64_t addr, const region_t & r) { return addr < r.begin; });
+    if (it == table->begin() || vaddr >= (it - 1)->end) {
+        return;
+    }
+    const region_t & region = *(it - 1);
+    module_t * module = region.module;
+    if (!module->ready.load(memory_order_acquire)) {
+        return;
+    }
+    
+    int64_t begin = vaddr - region.begin + region.offset;
+    int64_t end = min<int64_t>(begin + (1 << qemu_plugin_mem_size_shift(info)), module->coverage.size);
+    if (!in_ranges(module->code_ranges, begin)) {
+        return;
+    }
+    for (int64_t offset = begin; offset < end; ++offset) {
+        atomic<uint64_t> & word = module->coverage.data_read[offset / 64];
+        uint64_t bit = 1ull << (offset % 64);
+        if (!(word.load(memory_order_relaxed) & bit)) {
+            word.fetch_or(bit, memory_order_relaxed);
+        }
+    }
+}
+
+static void edge_insert(edge_set_t & set, uint64_t source, uint64_t target)
+{
+    // Keep the load factor under 1/2
+    if ((set.used + 1) * 2 > set.slots.size()) {
+        vector<pair<uint64_t, uint64_t>> old(max<size_t>(1024, set.slots.size() * 2));
+        old.swap(set.slots);
+        set.used = 0;
+        for (const auto & [s, t] : old) {
+            if (s) {
+                edge_insert(set, s, t);
+            }
+        }
+    }
+    size_t mask = set.slots.size() - 1;
+    size_t i = ((source * 0x9E3779B97F4A7C15ull) ^ (target * 0xC2B2AE3D27D4EB4Full)) >> 17 & mask;
+    while (set.slots[i].first) {
+        if (set.slots[i].first == source && set.slots[i].second == target) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+    set.slots[i] = { source, target };
+    ++set.used;
+}
+
+static void count_add(count_map_t & map, uint64_t key, uint64_t count)
+{
+    // Keep the load factor under 1/2
+    if ((map.used + 1) * 2 > map.slots.size()) {
+        vector<pair<uint64_t, uint64_t>> old(max<size_t>(1024, map.slots.size() * 2));
+        old.swap(map.slots);
+        map.used = 0;
+        for (const auto & [k, c] : old) {
+            if (k) {
+                count_add(map, k, c);
+            }
+        }
+    }
+    size_t mask = map.slots.size() - 1;
+    size_t i = (key * 0x9E3779B97F4A7C15ull) >> 17 & mask;
+    while (map.slots[i].first && map.slots[i].first != key) {
+        i = (i + 1) & mask;
+    }
+    if (!map.slots[i].first) {
+        map.slots[i].first = key;
+        ++map.used;
+    }
+    map.slots[i].second += count;
+}
+
+/*
+ * counts=1 and/or edges=1
+ * Execution counts are per-vCPU counters keyed by descriptor, so that counting never contends
+ * An edge is recorded when this TB is not where the previous one would fall through to. This
+ * also skips the return of a call into another module, which resumes right after the call.
+ */
+static void vcpu_tb_profile(unsigned int vcpu_index, void *userdata)
+{
+    tb_desc_t * desc = (tb_desc_t *) userdata;
+    vcpu_state_t & vcpu = get_vcpu(vcpu_index);
+    if (record_counts) {
+        count_map_t & counts = vcpu.tb_counts;
+        // Same condition as the rehash in count_add
+        if ((counts.used + 1) * 2 > counts.slots.size()) {
+            lock_guard<mutex> guard(vcpu.grow_lock);
+            count_add(counts, desc->id + 1, 1);
+        } else {
+            count_add(counts, desc->id + 1, 1);
+        }
+    }
+    if (record_edges) {
+        const tb_desc_t * last = vcpu.last_tb;
+        if (last && last->module == desc->module && desc->entry != -1 && desc->entry != last->end) {
+            uint64_t source = insn_key(last->module, last->last), target = insn_key(desc->module, desc->entry);
+            // Same condition as the rehash in edge_insert
+            if ((vcpu.edges.used + 1) * 2 > vcpu.edges.slots.size()) {
+                lock_guard<mutex> guard(vcpu.grow_lock);
+                edge_insert(vcpu.edges, source, target);
+            } else {
+                edge_insert(vcpu.edges, source, target);
+            }
+        }
+        vcpu.last_tb = desc;
+    }
+    if (record_functions) {
+        // Landing right after the call is not a call target, e.g. call/pop to get the PC
+        if (vcpu.call_return && desc->entry != -1 && desc->vaddr != vcpu.call_return
+                && !desc->called.load(memory_order_relaxed)) {
+            desc->called.store(true, memory_order_relaxed);
+        }
+        vcpu.call_return = desc->call_return;
+    }
+    ++vcpu.callbacks;
+    record_tb(vcpu, desc);
+}
+
+// edges=1 and/or functions=1: a TB outside the recorded modules breaks the chain of TBs
+// userdata is the guest address after the call ending the TB, if any, so that calls from
+// other modules (e.g. libc into main) still mark their targets
+static void vcpu_tb_leave(unsigned int vcpu_index, void *userdata)
+{
+    vcpu_state_t & vcpu = get_vcpu(vcpu_index);
+    ++vcpu.callbacks;
+    vcpu.last_tb = nullptr;
+    vcpu.call_return = (uint64_t) userdata;
+}
+
+// functions=1: near calls, direct (E8) or indirect (FF /2), after any prefixes
+static bool is_call_x86_64(const uint8_t * bytes, size_t size)
+{
+    size_t i = 0;
+    while (i < size && (bytes[i] == 0x66 || bytes[i] == 0x67 || bytes[i] == 0xF2 || bytes[i] == 0xF3
+            || bytes[i] == 0x2E || bytes[i] == 0x3E || bytes[i] == 0x26 || bytes[i] == 0x36
+            || bytes[i] == 0x64 || bytes[i] == 0x65)) {
+        ++i;
+    }
+    if (i < size && (bytes[i] & 0xF0) == 0x40) {
+        ++i;
+    }
+    if (i >= size) {
+        return false;
+    }
+    return bytes[i] == 0xE8 || (bytes[i] == 0xFF && i + 1 < size && ((bytes[i + 1] >> 3) & 7) == 2);
+}
+
+// functions=1: BL, BLR and the pointer-authenticated BLRAA/BLRAB(Z)
+static bool is_call_aarch64(const uint8_t * bytes, size_t size)
+{
+    uint32_t word;
+    if (size != sizeof(word)) {
+        return false;
+    }
+    memcpy(&word, bytes, sizeof(word));
+    return (word & 0xFC000000) == 0x94000000
+        || (word & 0xFFFFFC1F) == 0xD63F0000
+        || (word & 0xFEFFF800) == 0xD63F0800;
+}
+
+static bool ends_in_call(struct qemu_plugin_insn * insn)
+{
+    return is_call && is_call((const uint8_t *) qemu_plugin_insn_data(insn), qemu_plugin_insn_size(insn));
+}
+
+static void plugin_reinstall(qemu_plugin_id_t id);
+
+static void vcpu_tb_once(unsigned int vcpu_index, void *userdata)
+{
+    tb_desc_t * desc = (tb_desc_t *) userdata;
+    vcpu_state_t & vcpu = get_vcpu(vcpu_index);
+    ++vcpu.callbacks;
+    if (desc->recorded.load(memory_order_relaxed) || desc->recorded.exchange(true)) {
+        return;
+    }
+    record_tb(vcpu, desc);
+    
+    if (quiet_tbs.fetch_add(1, memory_order_relaxed) + 1 >= quiet_threshold.load(memory_order_relaxed)
+        && !flush_pending.exchange(true)) {
+        qemu_plugin_reset(plugin_id, plugin_reinstall);
+    }
+}
+
+static void plugin_saturated(qemu_plugin_id_t id);
+
+// saturate=<N>: userdata is the number of guest instructions in the TB, wherever they are mapped
+static void vcpu_tb_watch(unsigned int vcpu_index, void *userdata)
+{
+    vcpu_state_t & vcpu = get_vcpu(vcpu_index);
+    ++vcpu.callbacks;
+    uint64_t found = discoveries.load(memory_order_relaxed);
+    if (found != vcpu.seen_discoveries) {
+        vcpu.seen_discoveries = found;
+        vcpu.quiet_insns = 0;
+    }
+    vcpu.quiet_insns += (uint64_t) userdata;
+    if (vcpu.quiet_insns >= saturate_insns && !saturated.load(memory_order_relaxed) && !saturated.exchange(true)) {
+        // Ignored if an exec=once flush is pending, plugin_reinstall then finishes instead
+        qemu_plugin_reset(plugin_id, plugin_saturated);
+    }
+}
+
+static void push_tb_desc(tb_desc_t * desc)
+{
+    desc->next = tb_descs.load(memory_order_relaxed);
+    while (!tb_descs.compare_exchange_weak(desc->next, desc, memory_order_release, memory_order_relaxed));
+}
+
+static void free_tb_descs()
+{
+    tb_desc_t * desc = tb_descs.exchange(nullptr);
+    while (desc) {
+        tb_desc_t * next = desc->next;
+        delete desc;
+        desc = next;
+    }
+}
+
+static void checkpoint_signal(int signum)
+{
+    // sem_post is async-signal-safe, the checkpoint thread does the actual work
+    sem_post(&checkpoint_sem);
+}
+
+/*
+ * Installed on the first translation rather than at install time, as QEMU user mode sets up its
+ * own host signal handlers after loading plugins. The guest no longer receives SIGUSR1 from outside.
+ */
+static void install_signal_handler()
+{
+    struct sigaction action = {};
+    action.sa_handler = checkpoint_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, nullptr);
+}
+
+/**
+ * On translation block new translation
+ *
+ * QEMU convert code by translation block (TB). By hooking here we can then hook
+ * a callback on each instruction and memory access.
+ *
+ * One TB might contain multiple instructions
+ * Note: not all instructions translated might be executed - so hook is set with instruction callback
+ * Note2: with MTTCG this runs concurrently on several vCPU threads, so it only touches the
+ * atomic coverage tables, the immutable mapping table and the lock-free descriptor list
+ */
+static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
+{
+    struct qemu_plugin_insn *insn;
+    tb_desc_t * desc = nullptr;
+    // mode=2: the block as seen in the first module it touches
+    module_t * block_module = nullptr;
+    tb_record_t block = {};
+    
+    if (checkpoint_on_signal) {
+        call_once(signal_once, install_signal_handler);
+    }
+    
+    int n = qemu_plugin_tb_n_insns(tb);
+    bool outside = true;
+    if (n > 0) {
+        insn = qemu_plugin_tb_get_insn(tb, n - 1);
+        outside = outside_regions(qemu_plugin_tb_vaddr(tb), qemu_plugin_insn_vaddr(insn) + qemu_plugin_insn_size(insn));
+    }
+    stats.tbs_translated.fetch_add(1, memory_order_relaxed);
+    stats.tbs_rejected.fetch_add(outside, memory_order_relaxed);
+    stats.insns_translated.fetch_add(n, memory_order_relaxed);
+    uint64_t instrumented = 0;
+    
+    // Outside the recorded mappings, instructions only matter for their loads
+    for (int i = 0; i < n && (!outside || record_data); ++i) {
+        insn = qemu_plugin_tb_get_insn(tb, i);
+        
+        uint64_t vaddr = qemu_plugin_insn_vaddr(insn);
+        module_t * module = nullptr;
+        int64_t offset = outside ? -1 : resolve_mapping(vaddr, module);
+        if (offset != -1 && ((desc && module != desc->module) || is_filtered_out(module, offset))) {
+            offset = -1;
+        }
+        
+        // void * aka uint64_t, module id is never 0 so the key is never null
+        void * insn_data = nullptr;
+        // Store only instructions that match with the static file
+        if (offset != -1) {
+            uint8_t length = (uint8_t) qemu_plugin_insn_size(insn);
+            
+            // module, offset, length
+            insn_data = (void*) insn_key(module, offset);
+            ++instrumented;
+            module->coverage.length[offset].store(length, memory_order_relaxed);
+            
+            // memcmp is vectorised by the C library, and instructions are 15 bytes at most
+            if (verify_code && (offset + length > (int64_t) module->coverage.size
+                    || memcmp(qemu_plugin_insn_data(insn), module->coverage.image + offset, length))) {
+                module->coverage.modified[offset / 64].fetch_or(1ull << (offset % 64), memory_order_relaxed);
+            }
+            
+            if (output_mode == 2 && (!block_module || module == block_module)) {
+                if (!block_module) {
+                    block_module = module;
+                    block.offset = offset;
+                }
+                ++block.instructions;
+                block.size += length;
+            }
+            
+            if (exec_mode == EXEC_TB || exec_mode == EXEC_ONCE) {
+                if (!desc) {
+                    desc = new tb_desc_t;
+                    desc->id = n_tb_descs.fetch_add(1, memory_order_relaxed);
+                    desc->module = module;
+                    desc->offsets.reserve(n - i);
+                    if (i == 0) {
+                        desc->entry = offset;
+                    }
+                }
+                desc->offsets.push_back(offset);
+                desc->last = offset;
+                desc->end = offset + length;
+            }
+        }
+        
+        /* data=1: loads anywhere may read the recorded files' code, e.g. memcpy from libc */
+        if (record_data) {
+            qemu_plugin_register_vcpu_mem_cb(insn, vcpu_mem_read, QEMU_PLUGIN_CB_NO_REGS, QEMU_PLUGIN_MEM_R, nullptr);
+        }
+        
+        /* Register callback on instruction, none for instructions that are not recorded */
+        if (exec_mode == EXEC_INSN && insn_data) {
+            qemu_plugin_register_vcpu_insn_exec_cb(insn, vcpu_insn_exec, QEMU_PLUGIN_CB_NO_REGS, insn_data);
+        } else if (exec_mode == EXEC_INLINE && offset != -1) {
+            // The add is not atomic across vCPUs, which is fine: any non-zero slot means executed
+            // counts=1 takes the slots as counts, so they undercount when guest threads run the
+            // same code in parallel
+            qemu_plugin_register_vcpu_insn_exec_inline(insn, QEMU_PLUGIN_INLINE_ADD_U64, &module->coverage.hits[offset], 1);
+        }
+    }
+    
+    stats.insns_instrumented.fetch_add(instrumented, memory_order_relaxed);
+    
+    /* mode=2: translation alone is recorded, whether the block runs is told by the coverage at exit */
+    if (block_module) {
+        tb_record_t * record = new tb_record_t(block);
+        record->next = block_module->blocks.load(memory_order_relaxed);
+        while (!block_module->blocks.compare_exchange_weak(record->next, record, memory_order_release, memory_order_relaxed));
+    }
+    
+    /* exec=once: a retranslated TB with nothing left to record stays uninstrumented */
+    if (desc && exec_mode == EXEC_ONCE && all_of(desc->offsets.begin(), desc->offsets.end(),
+            [desc](int64_t offset) { return is_executed(desc->module->coverage, offset); })) {
+        delete desc;
+        desc = nullptr;
+    }
+    
+    /* functions=1: only the last instruction of a TB can be a call */
+    uint64_t call_return = 0;
+    if (record_functions && n > 0) {
+        insn = qemu_plugin_tb_get_insn(tb, n - 1);
+        if (ends_in_call(insn)) {
+            call_return = qemu_plugin_insn_vaddr(insn) + qemu_plugin_insn_size(insn);
+        }
+    }
+    
+    /* Register a single callback for the whole TB, only if it touches the target */
+    if (desc) {
+        desc->vaddr = qemu_plugin_tb_vaddr(tb);
+        desc->call_return = call_return;
+        push_tb_desc(desc);
+        qemu_plugin_register_vcpu_tb_exec_cb(tb, exec_mode == EXEC_ONCE ? vcpu_tb_once
+                                                 : record_counts || record_edges || record_functions ? vcpu_tb_profile : vcpu_tb_exec,
+                                             QEMU_PLUGIN_CB_NO_REGS, desc);
+    } else if (record_edges || record_functions) {
+        qemu_plugin_register_vcpu_tb_exec_cb(tb, vcpu_tb_leave, QEMU_PLUGIN_CB_NO_REGS, (void *) call_return);
+    }
+    
+    /* timeline=insns: the clock counts every guest instruction, wherever it is mapped */
+    if (timeline_clock == TIMELINE_INSNS && n > 0) {
+        qemu_plugin_register_vcpu_tb_exec_inline(tb, QEMU_PLUGIN_INLINE_ADD_U64, &guest_insns.value, n);
+    }
+    
+    /* saturate=<N>: every TB counts towards the quiet period, not only those of recorded modules */
+    if (saturate_insns && n > 0) {
+        qemu_plugin_register_vcpu_tb_exec_cb(tb, vcpu_tb_watch, QEMU_PLUGIN_CB_NO_REGS, (void *) (uint64_t) n);
+    }
+}
+
+// This function parses a module's ELF header and find out the image loading base address
+// data=1: also collects the file ranges [begin, end) of all executable sections, sorted
+static int64_t parse_base_address(const string & filename, vector<pair<int64_t, int64_t>> * code_ranges)
+{
+    // Resolve section offset from ELF header
+    // Ref: https://github.com/TheCodeArtist/elf-parser/blob/master/elf-parser-main.c
+    int elffd = open(filename.c_str(), O_RDONLY|O_SYNC);
+    Elf32_Ehdr eh;
+    read_elf_header(elffd, &eh);
+    
+    // base address where file offsets will add up to it
+    int64_t base_address = 0;
+    bool found = false;
+    
+    if(is64Bit(eh)){
+		Elf64_Ehdr eh64;	/* elf-header is fixed size */
+		Elf64_Shdr* sh_tbl;	/* section-header table is variable size */
+
+		read_elf_header64(elffd, &eh64);
+
+		/* Section header table :  */
+		sh_tbl = (Elf64_Shdr*) malloc(eh64.e_shentsize * eh64.e_shnum);
+		read_section_header_table64(elffd, eh64, sh_tbl);
+		
+		for (int i = 0; i < eh64.e_shnum; ++i) {
+		    int flag = sh_tbl[i].sh_flags;
+		    // 0x2: SHF_ALLOC
+		    // 0x4: SHF_EXECINSTR
+		    // See: https://docs.oracle.com/cd/E19120-01/open.solaris/819-0690/6n33n7fcj/index.html
+		    if ((flag & 0x2) && (flag & 0x4)) {
+		        if (!found) {
+		            base_address = sh_tbl[i].sh_addr - sh_tbl[i].sh_offset;
+		            found = true;
+		        }
+		        if (!code_ranges) {
+		            break;
+		        }
+		        code_ranges->emplace_back(sh_tbl[i].sh_offset, sh_tbl[i].sh_offset + sh_tbl[i].sh_size);
+		    }
+		}
+		free(sh_tbl);
+	} else{
+		Elf32_Shdr* sh_tbl = (Elf32_Shdr*) malloc(eh.e_shentsize * eh.e_shnum);
+		read_section_header_table(elffd, eh, sh_tbl);
+		
+		for (int i = 0; i < eh.e_shnum; ++i) {
+		    int flag = sh_tbl[i].sh_flags;
+		    // 0x2: SHF_ALLOC
+		    // 0x4: SHF_EXECINSTR
+		    // See: https://docs.oracle.com/cd/E19120-01/open.solaris/819-0690/6n33n7fcj/index.html
+		    if ((flag & 0x2) && (flag & 0x4)) {
+		        if (!found) {
+		            base_address = sh_tbl[i].sh_addr - sh_tbl[i].sh_offset;
+		            found = true;
+		        }
+		        if (!code_ranges) {
+		            break;
+		        }
+		        code_ranges->emplace_back(sh_tbl[i].sh_offset, sh_tbl[i].sh_offset + sh_tbl[i].sh_size);
+		    }
+		}
+		free(sh_tbl);
+	}
+	
+	close(elffd);
+	if (code_ranges) {
+	    sort(code_ranges->begin(), code_ranges->end());
+	}
+	
+	logger << "Base Address parsed @0x" << hex << base_address << dec << endl;
+	
+	return base_address;
+}
+
+/*
+ * Collect recorded insn, a linear scan over the bitset yields them already sorted
+ * The bitset is split into one slice per host thread, each scanned on its own thread
+ * counts=1: the execution counts are taken from the per-offset slots
+ */
+static void collect_instructions(const coverage_t & coverage, vector<capture_insn_t> & instructions)
+{
+    size_t words = (coverage.size + 63) / 64;
+    size_t n_threads = max(1u, min(thread::hardware_concurrency(), 16u));
+    size_t slice = (words + n_threads - 1) / n_threads;
+    const volatile uint64_t * hits = record_counts ? coverage.hits : nullptr;
+    
+    vector<vector<capture_insn_t>> found(n_threads);
+    vector<thread> workers;
+    for (size_t t = 0; t < n_threads; ++t) {
+        workers.emplace_back([&, t]() {
+            for (size_t w = t * slice; w < min(words, (t + 1) * slice); ++w) {
+                uint64_t bits = coverage.executed[w].load(memory_order_relaxed);
+                while (bits) {
+                    int64_t offset = w * 64 + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    int8_t length = coverage.length[offset].load(memory_order_relaxed);
+                    // A bit without a length cannot be written out, it would read back as empty
+                    if (length) {
+                        found[t].push_back({ offset, length, hits ? hits[offset] : 0 });
+                    }
+                }
+            }
+        });
+    }
+    for (thread & worker : workers) {
+        worker.join();
+    }
+    
+    size_t total = 0;
+    for (const auto & part : found) {
+        total += part.size();
+    }
+    instructions.reserve(total);
+    for (const auto & part : found) {
+        instructions.insert(instructions.end(), part.begin(), part.end());
+    }
+}
+
+// Save file is base name + .capnp.out
+static string output_name(const module_t * module)
+{
+    const string & filename = module->filename;
+    return filename.substr(filename.rfind('/') + 1) + ".capnp.out";
+}
+
+static string checkpoint_name(const module_t * module, pid_t pid)
+{
+    return output_name(module) + "." + to_string(pid) + ".ckpt";
+}
+
+// Unique among all processes sharing the working directory, a process may save more than once (execve)
+static string segment_name(const module_t * module)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return output_name(module) + "." + to_string(getpid()) + "." + to_string(now.tv_sec * 1000000000ull + now.tv_nsec) + ".seg";
+}
+
+static vector<string> list_segments(const module_t * module)
+{
+    vector<string> segments;
+    string pattern = output_name(module) + ".*.seg";
+    glob_t matches;
+    if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+        segments.assign(matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+    }
+    globfree(&matches);
+    return segments;
+}
+
+// Ref: https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ull
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define XXH_PRIME64_3 0x165667B19E3779F9ull
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ull
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ull
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_PRIME64_2;
+    acc = (acc << 31) | (acc >> 33);
+    return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t xxh64_merge(uint64_t acc, uint64_t value)
+{
+    acc ^= xxh64_round(0, value);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static inline uint64_t rotl64(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t xxh64(const uint8_t * data, size_t size)
+{
+    const uint8_t * p = data, * end = data + size;
+    uint64_t h, word;
+    uint32_t half;
+    
+    if (size >= 32) {
+        uint64_t v1 = XXH_PRIME64_1 + XXH_PRIME64_2, v2 = XXH_PRIME64_2, v3 = 0, v4 = -XXH_PRIME64_1;
+        for (; p + 32 <= end; p += 32) {
+            memcpy(&word, p, 8);      v1 = xxh64_round(v1, word);
+            memcpy(&word, p + 8, 8);  v2 = xxh64_round(v2, word);
+            memcpy(&word, p + 16, 8); v3 = xxh64_round(v3, word);
+            memcpy(&word, p + 24, 8); v4 = xxh64_round(v4, word);
+        }
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge(xxh64_merge(xxh64_merge(xxh64_merge(h, v1), v2), v3), v4);
+    } else {
+        h = XXH_PRIME64_5;
+    }
+    h += size;
+    
+    for (; p + 8 <= end; p += 8) {
+        memcpy(&word, p, 8);
+        h = rotl64(h ^ xxh64_round(0, word), 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        memcpy(&half, p, 4);
+        h = rotl64(h ^ (half * XXH_PRIME64_1), 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h = rotl64(h ^ (*p * XXH_PRIME64_5), 11) * XXH_PRIME64_1;
+    }
+    
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    return h ^ (h >> 32);
+}
+
+/*
+ * Digest of a file, formatted as stored by schema_io: plain hex for MD5 (as printed by md5sum),
+ * XXH64_DIGEST_PREFIX and hex for XXH64. Empty if the file cannot be read.
+ * The file is mapped rather than read, so hashing streams through the page cache without copies
+ */
+static string compute_digest(const string & filename, digest_algorithm_t algorithm)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return "";
+    }
+    struct stat file_status;
+    if (fstat(fd, &file_status) == -1) {
+        close(fd);
+        return "";
+    }
+    size_t size = file_status.st_size;
+    const uint8_t * data = nullptr;
+    if (size) {
+        void * mem = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem == MAP_FAILED) {
+            close(fd);
+            return "";
+        }
+        madvise(mem, size, MADV_SEQUENTIAL);
+        data = (const uint8_t *) mem;
+    }
+    close(fd);
+    
+    string digest;
+    if (algorithm == DIGEST_XXH64) {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016" PRIx64, xxh64(data, size));
+        digest = XXH64_DIGEST_PREFIX + string(hex);
+    } else {
+        GChecksum * checksum = g_checksum_new(G_CHECKSUM_MD5);
+        g_checksum_update(checksum, data, size);
+        digest = g_checksum_get_string(checksum);
+        g_checksum_free(checksum);
+    }
+    
+    if (data) {
+        munmap((void *) data, size);
+    }
+    return digest;
+}
+
+static void compute_module_digest(module_t * module)
+{
+    module->digest = compute_digest(module->filename, digest_algorithm);
+}
+
+// Blocks until the digest is known if another thread is computing it
+static const string & module_digest(module_t * module)
+{
+    call_once(module->digest_once, compute_module_digest, module);
+    return module->digest;
+}
+
+// A digest of another capture may use another algorithm, e.g. after switching digest=
+static bool digest_matches(module_t * module, const string & other)
+{
+    digest_algorithm_t algorithm = other.compare(0, strlen(XXH64_DIGEST_PREFIX), XXH64_DIGEST_PREFIX) ? DIGEST_MD5 : DIGEST_XXH64;
+    if (algorithm == digest_algorithm) {
+        return other == module_digest(module);
+    }
+    return other == compute_digest(module->filename, algorithm);
+}
+
+static void join_digest_thread()
+{
+    if (digest_thread.joinable()) {
+        digest_thread.join();
+    }
+}
+
+// Requires log_lock, parsing logs the base address
+static int64_t module_base_address(module_t * module)
+{
+    if (module->base_address == -1) {
+        module->base_address = parse_base_address(module->filename, nullptr);
+    }
+    return module->base_address;
+}
+
+// Folds exec=inline counters into the executed bitset
+static void fold_hits(coverage_t & coverage)
+{
+    if (exec_mode != EXEC_INLINE || !coverage.hits) {
+        return;
+    }
+    // Counters are bumped by generated code on other threads, read them as volatile
+    const volatile uint64_t * hits = coverage.hits;
+    for (size_t offset = 0; offset < coverage.size; ++offset) {
+        if (hits[offset]) {
+            mark_executed(coverage, offset);
+        }
+    }
+}
+
+/*
+ * Appends every instruction recorded since the last checkpoint to this process' checkpoint file
+ * Only the checkpoint thread calls this, vCPUs keep running meanwhile
+ */
+static void write_checkpoint()
+{
+    lock_guard<mutex> save_guard(save_lock);
+    size_t total = 0;
+    for (uint32_t id = 1; id < n_modules.load(memory_order_acquire); ++id) {
+        module_t * module = modules[id].load(memory_order_acquire);
+        if (!module->ready.load(memory_order_acquire) || !module->coverage.size) {
+            continue;
+        }
+        coverage_t & coverage = module->coverage;
+        size_t words = (coverage.size + 63) / 64;
+        if (!module->checkpointed && !(module->checkpointed = (uint64_t *) alloc_lazy(words * sizeof(uint64_t)))) {
+            continue;
+        }
+        fold_hits(coverage);
+        
+        map<int64_t, int8_t> instructions;
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t bits = coverage.executed[w].load(memory_order_relaxed) & ~module->checkpointed[w];
+            module->checkpointed[w] |= bits;
+            while (bits) {
+                int64_t offset = w * 64 + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                if (int8_t length = coverage.length[offset].load(memory_order_relaxed)) {
+                    instructions.emplace_hint(instructions.end(), offset, length);
+                }
+            }
+        }
+        if (instructions.empty()) {
+            continue;
+        }
+        
+        string digest = module_digest(module);
+        string checkpoint = checkpoint_name(module, getpid());
+        int64_t base_address;
+        {
+            lock_guard<mutex> guard(log_lock);
+            base_address = module_base_address(module);
+        }
+        if (!append_version_1(checkpoint.c_str(), instructions, base_address, digest)) {
+            lock_guard<mutex> guard(log_lock);
+            logger << "Failed to append to " << checkpoint << endl;
+        }
+        total += instructions.size();
+    }
+    
+    lock_guard<mutex> guard(log_lock);
+    logger << "Checkpoint: " << total << " new instructions" << endl;
+}
+
+static void checkpoint_main()
+{
+    while (!checkpoint_stop.load()) {
+        if (checkpoint_interval) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += checkpoint_interval;
+            // Either the period elapsed (ETIMEDOUT) or SIGUSR1 arrived, checkpoint in both cases
+            while (sem_timedwait(&checkpoint_sem, &deadline) == -1 && errno == EINTR);
+        } else {
+            while (sem_wait(&checkpoint_sem) == -1 && errno == EINTR);
+        }
+        if (!checkpoint_stop.load()) {
+            write_checkpoint();
+        }
+    }
+}
+
+static void stop_checkpoint_thread()
+{
+    if (checkpoint_thread.joinable()) {
+        checkpoint_stop = true;
+        sem_post(&checkpoint_sem);
+        checkpoint_thread.join();
+    }
+}
+
+/*
+ * Checkpoint files of this output that no running process owns anymore
+ * Our own one is included, its content is already part of what this process recorded
+ */
+static vector<string> stale_checkpoints(const module_t * module)
+{
+    vector<string> stale;
+    string pattern = output_name(module) + ".*.ckpt";
+    glob_t matches;
+    if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+        for (size_t i = 0; i < matches.gl_pathc; ++i) {
+            const char * path = matches.gl_pathv[i];
+            pid_t pid = atoi(path + pattern.size() - strlen("*.ckpt"));
+            if (pid == getpid() || kill(pid, 0) == -1) {
+                stale.emplace_back(path);
+            }
+        }
+    }
+    globfree(&matches);
+    return stale;
+}
+
+/*
+ * counts=1: distribute the executions of each TB to the per-offset slots of its instructions
+ * With exec=inline the slots are bumped by the generated code already, approximate under MTTCG
+ */
+static void gather_counts()
+{
+    // Snapshot first, every id in the list is then below the count read after it
+    tb_desc_t * head = tb_descs.load(memory_order_acquire);
+    vector<uint64_t> totals(n_tb_descs);
+    for (atomic<vcpu_state_t *> & chunk : vcpu_chunks) {
+        vcpu_state_t * states = chunk.load();
+        for (size_t i = 0; states && i < VCPU_CHUNK_SIZE; ++i) {
+            lock_guard<mutex> guard(states[i].grow_lock);
+            for (const auto & [key, count] : states[i].tb_counts.slots) {
+                if (key && key - 1 < totals.size()) {
+                    totals[key - 1] += count;
+                }
+            }
+        }
+    }
+    for (tb_desc_t * desc = head; desc; desc = desc->next) {
+        coverage_t & coverage = desc->module->coverage;
+        if (desc->id >= totals.size() || !totals[desc->id]) {
+            continue;
+        }
+        for (int64_t offset : desc->offsets) {
+            coverage.hits[offset] += totals[desc->id];
+        }
+    }
+}
+
+// edges=1: union of the edges seen by all vCPUs, split by module
+static void gather_edges()
+{
+    const uint64_t offset_mask = (1ull << OFFSET_BITS) - 1;
+    for (atomic<vcpu_state_t *> & chunk : vcpu_chunks) {
+        vcpu_state_t * states = chunk.load();
+        for (size_t i = 0; states && i < VCPU_CHUNK_SIZE; ++i) {
+            lock_guard<mutex> guard(states[i].grow_lock);
+            for (const auto & [source, target] : states[i].edges.slots) {
+                if (source) {
+                    module_t * module = modules[source >> OFFSET_BITS].load();
+                    module->details.edges.emplace(source & offset_mask, target & offset_mask);
+                }
+            }
+        }
+    }
+}
+
+// timeline=: first executions of all vCPUs in clock order, split by module
+static void gather_timeline()
+{
+    vector<pair<uint64_t, uint64_t>> first_hits;
+    for (atomic<vcpu_state_t *> & chunk : vcpu_chunks) {
+        vcpu_state_t * states = chunk.load();
+        for (size_t i = 0; states && i < VCPU_CHUNK_SIZE; ++i) {
+            lock_guard<mutex> guard(states[i].grow_lock);
+            first_hits.insert(first_hits.end(), states[i].first_hits.begin(), states[i].first_hits.end());
+        }
+    }
+    stable_sort(first_hits.begin(), first_hits.end(),
+        [](const pair<uint64_t, uint64_t> & a, const pair<uint64_t, uint64_t> & b) { return a.second < b.second; });
+    for (const auto & [key, clock] : first_hits) {
+        module_t * module = modules[key >> OFFSET_BITS].load();
+        module->details.timeline.emplace_back(key & ((1ull << OFFSET_BITS) - 1), clock);
+        module->details.timeline_in_ns = timeline_clock == TIMELINE_TIME;
+    }
+}
+
+// mode=2: distinct translated blocks of each module, executed if their first instruction was
+static void gather_blocks()
+{
+    for (uint32_t id = 1; id < n_modules.load(memory_order_acquire); ++id) {
+        module_t * module = modules[id].load(memory_order_acquire);
+        for (tb_record_t * block = module->blocks.load(memory_order_acquire); block; block = block->next) {
+            module->details.blocks[{ block->offset, block->instructions, block->size }]
+                |= is_executed(module->coverage, block->offset);
+        }
+    }
+}
+
+// data=1: coalesces the bytes of code read as data into ranges
+static void gather_data()
+{
+    for (uint32_t id = 1; id < n_modules.load(memory_order_acquire); ++id) {
+        module_t * module = modules[id].load(memory_order_acquire);
+        const coverage_t & coverage = module->coverage;
+        if (!module->ready.load(memory_order_acquire) || !coverage.data_read) {
+            continue;
+        }
+        int64_t begin = -1;
+        for (size_t w = 0; w < (coverage.size + 63) / 64; ++w) {
+            uint64_t bits = coverage.data_read[w].load(memory_order_relaxed);
+            // Whole words outside or inside a range, the common cases
+            if ((begin == -1 && !bits) || (begin != -1 && !~bits)) {
+                continue;
+            }
+            for (size_t b = 0; b < 64; ++b) {
+                bool read = (bits >> b) & 1;
+                if (read && begin == -1) {
+                    begin = w * 64 + b;
+                } else if (!read && begin != -1) {
+                    add_data_range(module->details.data, begin, w * 64 + b);
+                    begin = -1;
+                }
+            }
+        }
+        if (begin != -1) {
+            add_data_range(module->details.data, begin, coverage.size);
+        }
+    }
+}
+
+// verify=1: instructions whose translated bytes differed from the file at least once
+static void gather_modified()
+{
+    for (uint32_t id = 1; id < n_modules.load(memory_order_acquire); ++id) {
+        module_t * module = modules[id].load(memory_order_acquire);
+        const coverage_t & coverage = module->coverage;
+        if (!module->ready.load(memory_order_acquire) || !coverage.modified) {
+            continue;
+        }
+        for (size_t w = 0; w < (coverage.size + 63) / 64; ++w) {
+            uint64_t bits = coverage.modified[w].load(memory_order_relaxed);
+            while (bits) {
+                module->details.modified.insert(w * 64 + __builtin_ctzll(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+}
+
+// functions=1: entries of all TBs ever entered right after a call
+static void gather_functions()
+{
+    for (tb_desc_t * desc = tb_descs.load(); desc; desc = desc->next) {
+        if (desc->called) {
+            desc->module->details.functions.insert(desc->entry);
+        }
     }
-    return result;
 }
 
+// Adds another capture of the same file: execution counts add up, everything else is a union
+static void merge_capture(vector<capture_insn_t> & instructions, capture_details_t & details,
+                          const vector<capture_insn_t> & other_instructions, const capture_details_t & other_details)
+{
+    merge_instructions(instructions, other_instructions);
+    details.edges.insert(other_details.edges.begin(), other_details.edges.end());
+    details.functions.insert(other_details.functions.begin(), other_details.functions.end());
+    details.modified.insert(other_details.modified.begin(), other_details.modified.end());
+    for (const auto & [begin, end] : other_details.data) {
+        add_data_range(details.data, begin, end);
+    }
+    for (const auto & [block, executed] : other_details.blocks) {
+        details.blocks[block] |= executed;
+    }
+    if (details.timeline.empty()) {
+        details.timeline = other_details.timeline;
+        details.timeline_in_ns = other_details.timeline_in_ns;
+    }
+}
 
-// We *NOT ONLY* care about segments with x permission
-// Note that original file is mapped with non-executable permission
-// Also to ignore all files that does not match the filename
-static void update_mapping()
+/*
+ * Merges every segment of the module into <base_name_of_module>.capnp.out (and with the existing
+ * output for version 1), then removes them. Requires the flock on <output>.lock.
+ * Returns false if the output could not be written, the segments are kept then
+ * own is the segment this process just published, its content is taken from instructions rather
+ * than read back, unless another process compacted it already
+ */
+static bool compact_segments(module_t * module, const string & own, const vector<capture_insn_t> & instructions)
 {
-    char buffer[512];
-    char dispose[64];
-    int pid = getpid();
-    sprintf(buffer, "/proc/%d/maps", pid);
+    string output = output_name(module);
+    string digest = module_digest(module);
+    vector<string> segments = list_segments(module);
+    vector<string> checkpoints = stale_checkpoints(module);
     
-    ifstream m(buffer);
+    // Our own segment first, so that its timeline is the one kept (merge_capture keeps the first)
+    stable_partition(segments.begin(), segments.end(), [&own](const string & path) { return path == own; });
     
-    string filename;
-    char permission[5];
-    uint64_t offset, inode, begin, end;
-    
-    while (m.getline(buffer, 512)) {
-        istringstream line(buffer);
-        line >> buffer >> permission >> hex >> offset >> dec >> dispose >> inode;
-        if (inode != 0) {
-            line >> filename;
-        } else {
+    vector<capture_insn_t> merged;
+    capture_details_t details;
+    uint64_t start = monotonic_ns();
+    for (const string & path : segments) {
+        if (path == own) {
+            logger << "Merging " << instructions.size() << " instructions captured in this run" << endl;
+            merge_capture(merged, details, instructions, module->details);
             continue;
         }
-        
-        const string * filename_ptr = &(*filename_table.insert(filename).first);
-        if (filename_ptr != target_filename) {
-            continue;
+        string segment_digest;
+        int64_t segment_base_address;
+        vector<capture_insn_t> segment_instructions;
+        capture_details_t segment_details;
+        if (!read_version_1(path.c_str(), segment_instructions, segment_base_address, segment_digest, segment_details)) {
+            logger << "Failed to read from " << path << ", discarding it" << endl;
+        } else if (!digest_matches(module, segment_digest)) {
+            logger << "Digest mismatch, discarding " << path << endl;
+        } else {
+            logger << "Merging " << segment_instructions.size() << " instructions from " << path << endl;
+            merge_capture(merged, details, segment_instructions, segment_details);
+        }
+    }
+    stats.merge_ns += monotonic_ns() - start;
+    
+    // Readers of the output never see a partial file, the result goes to a new file renamed over it
+    string temporary = output + "." + to_string(getpid()) + ".tmp";
+    bool saved;
+    if (output_version == 0) {
+        // Version 0 has no digest to check foreign checkpoints against, only drop our own
+        checkpoints.assign(1, checkpoint_name(module, getpid()));
+        start = monotonic_ns();
+        saved = write_version_0(temporary.c_str(), merged, module_base_address(module), details.functions);
+    } else {
+        // Checkpoints of earlier runs that were killed before reaching their exit
+        start = monotonic_ns();
+        for (const string & checkpoint : checkpoints) {
+            string checkpoint_digest;
+            int64_t checkpoint_base_address;
+            vector<capture_insn_t> checkpoint_instructions;
+            capture_details_t checkpoint_details;
+            if (read_version_1(checkpoint.c_str(), checkpoint_instructions, checkpoint_base_address, checkpoint_digest, checkpoint_details)
+                && digest_matches(module, checkpoint_digest)) {
+                logger << "Merging " << checkpoint_instructions.size() << " instructions from " << checkpoint << endl;
+                merge_instructions(merged, checkpoint_instructions);
+            }
         }
+        stats.merge_ns += monotonic_ns() - start;
         
-        // convert range to integer
-        char * delim = strchr(buffer, '-');
-        *delim = 0;
-        begin = stoull(buffer, nullptr, 16);
-        end = stoull(delim + 1, nullptr, 16);
+        start = monotonic_ns();
+        int64_t base_address = -1;
+        bool merge_original = false;
+        if (file_exists(output.c_str())) {
+            logger << "Output exists. Checking it." << endl;
+            string original_digest;
+            if (!read_header_version_1(output.c_str(), base_address, original_digest)) {
+                logger << "Failed to read from input file" << endl;
+                base_address = -1;
+            } else if (!digest_matches(module, original_digest)) {
+                logger << "Digest mismatch, probably due to a recompilation of the file" << endl;
+                logger << "Original output digest: " << original_digest << endl;
+                logger << "Original output will be disposed" << endl;
+                base_address = -1;
+            } else {
+                logger << "Original output digest match" << endl;
+                merge_original = true;
+            }
+        }
+        if (base_address == -1) {
+            base_address = module_base_address(module);
+        }
+        stats.read_old_ns += monotonic_ns() - start;
         
-        mapping_table.emplace(begin, end, offset, filename_ptr);
+        start = monotonic_ns();
+        if (merge_original) {
+            size_t n_merged;
+            logger << "Merging " << merged.size() << " instructions with the old capture file" << endl;
+            saved = merge_version_1(temporary.c_str(), output.c_str(), merged, base_address, digest, details, n_merged, write_extents);
+            if (saved) {
+                logger << "#Insns after merging two sets = " << n_merged << endl;
+            }
+        } else {
+            saved = write_version_1(temporary.c_str(), merged, base_address, digest, details, write_extents);
+        }
+    }
+    if (saved && rename(temporary.c_str(), output.c_str()) == -1) {
+        logger << "Unable to rename " << temporary << ": " << strerror(errno) << endl;
+        saved = false;
     }
+    stats.write_ns += monotonic_ns() - start;
     
-    has_mapped = true;
+    if (!saved) {
+        logger << "Failed to write to output file, segments are left for the next run" << endl;
+        unlink(temporary.c_str());
+        return false;
+    }
+    for (const string & path : segments) {
+        unlink(path.c_str());
+    }
+    for (const string & checkpoint : checkpoints) {
+        unlink(checkpoint.c_str());
+    }
+    return true;
 }
 
 /*
- * For the sake of efficiency, we assumed that mapping stays unchanged
- * throughout execution.
- *
- * Inputs virtual address, outputs offset
+ * Publishes this process' capture of the module as a segment, then compacts the segments unless
+ * another process is at it already
  *
- * This should always succeed - it should not enter infinite loop
+ * A process that fails to get the lock published its segment before trying, and the compacting
+ * process lists the segments again after unlocking, so no segment is left behind: either the
+ * compaction saw it, or the later listing does and compacts again.
  */
-static int64_t resolve_mapping(uint64_t vaddr)
+static void save_module(module_t * module, vector<capture_insn_t> & instructions)
 {
-    if (!has_mapped) {
-        update_mapping();
+    string output = output_name(module);
+	logger << "Saving " << instructions.size() << " instructions of " << module->filename << " to " << output << endl;
+    
+    uint64_t start = monotonic_ns();
+    string digest = module_digest(module);
+    stats.digest_ns += monotonic_ns() - start;
+    logger << "Executable digest: " << digest << endl;
+    
+    // Segments are always version 1, so that they can be checked against the digest, and made of
+    // extents, as only this plugin reads them
+    string segment = segment_name(module);
+    string temporary = segment.substr(0, segment.size() - strlen(".seg")) + ".tmp";
+    start = monotonic_ns();
+    if (!write_version_1(temporary.c_str(), instructions, module_base_address(module), digest, module->details, true)
+        || rename(temporary.c_str(), segment.c_str()) == -1) {
+        logger << "Failed to write to " << segment << endl;
+        unlink(temporary.c_str());
+        return;
     }
-    for (const mapping_t & mapping : mapping_table)
-    {
-        // no suitable range found
-        if (vaddr < get<0>(mapping)) {
+    stats.segment_ns += monotonic_ns() - start;
+    
+    string lock_name = output + ".lock";
+    int lock_fd = open(lock_name.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (lock_fd == -1) {
+        logger << "Unable to open " << lock_name << ": " << strerror(errno) << ", " << segment << " is left for the next run" << endl;
+        return;
+    }
+    while (!list_segments(module).empty()) {
+        if (flock(lock_fd, LOCK_EX | LOCK_NB) == -1) {
+            logger << "Another process is compacting " << output << ", leaving " << segment << " to it" << endl;
             break;
         }
-        if (vaddr >= get<1>(mapping)) {
-            continue;
+        bool compacted = compact_segments(module, segment, instructions);
+        flock(lock_fd, LOCK_UN);
+        if (!compacted) {
+            break;
         }
-        // now: begin <= vaddr < end
-        // vaddr - begin + base
-        int64_t offset = vaddr - get<0>(mapping) + get<2>(mapping);
-        return offset;
     }
-    
-    return -1;
+    close(lock_fd);
 }
 
-static void vcpu_insn_exec(unsigned int vcpu_index, void *userdata)
+static string json_string(const string & value)
 {
-    if (userdata) {
-        insn_executed[vcpu_index].insert((int64_t) userdata);
+    string quoted = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if ((unsigned char) c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+        } else {
+            quoted += c;
+        }
     }
+    return quoted + "\"";
 }
 
-/**
- * On translation block new translation
- *
- * QEMU convert code by translation block (TB). By hooking here we can then hook
- * a callback on each instruction and memory access.
- *
- * One TB might contain multiple instructions
- * Note: not all instructions translated might be executed - so hook is set with instruction callback
+/*
+ * Writes the counters and the timing of the save that just finished to the log, and appends them
+ * to capnp-capture.stats.jsonl as a single write, so that lines of concurrent processes never mix
+ * Requires log_lock
  */
-static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
+static void report_stats()
 {
-    struct qemu_plugin_insn *insn;
-    
-    int n = qemu_plugin_tb_n_insns(tb);
-    for (int i = 0; i < n; ++i) {
-        insn = qemu_plugin_tb_get_insn(tb, i);
-        
-        uint64_t vaddr = qemu_plugin_insn_vaddr(insn);
-        int64_t offset = resolve_mapping(vaddr);
-        
-        // void * aka uint64_t, assuming there is no instruction sitting at address 0
-        void * insn_data = nullptr;
-        // Store only instructions that match with the static file
-        if (offset != -1) {
-            uint8_t length = (uint8_t) qemu_plugin_insn_size(insn);
-            
-            // filename, offset, length
-            insn_data = (void*) offset;
-            insn_discovered[offset] = length;
+    uint64_t n_vcpus = 0, callbacks = 0, discovered = 0, edge_slots = 0, edges = 0, tb_counters = 0, first_hits = 0;
+    for (atomic<vcpu_state_t *> & chunk : vcpu_chunks) {
+        vcpu_state_t * states = chunk.load();
+        for (size_t i = 0; states && i < VCPU_CHUNK_SIZE; ++i) {
+            lock_guard<mutex> guard(states[i].grow_lock);
+            n_vcpus += states[i].initialized;
+            callbacks += states[i].callbacks;
+            discovered += states[i].discovered;
+            edge_slots += states[i].edges.slots.size();
+            edges += states[i].edges.used;
+            tb_counters += states[i].tb_counts.slots.size();
+            first_hits += states[i].first_hits.size();
         }
-        
-        /* Register callback on instruction */
-        qemu_plugin_register_vcpu_insn_exec_cb(insn, vcpu_insn_exec, QEMU_PLUGIN_CB_NO_REGS, insn_data);
     }
-}
-
-// This function parses target's ELF header and find out the image loading base address
-static int64_t parse_base_address()
-{
-    // Resolve section offset from ELF header
-    // Ref: https://github.com/TheCodeArtist/elf-parser/blob/master/elf-parser-main.c
-    int elffd = open(target_filename->c_str(), O_RDONLY|O_SYNC);
-    Elf32_Ehdr eh;
-    read_elf_header(elffd, &eh);
+    const region_table_t * table = region_table.load(memory_order_acquire);
+    size_t regions = table ? table->size() : 0;
+    const char * exec_names[] = { "insn", "tb", "inline", "once" };
     
-    // base address where file offsets will add up to it
-    int64_t base_address = 0;
+    logger << "#Callbacks fired = " << callbacks << " on " << n_vcpus << " vCPUs, "
+           << discovered << " of them recorded a new instruction" << endl;
+    logger << "#TBs translated = " << stats.tbs_translated << " (" << stats.tbs_rejected << " outside the recorded files), "
+           << "instructions translated = " << stats.insns_translated << ", instrumented = " << stats.insns_instrumented << endl;
+    logger << "#Mapping lookups = " << stats.lookups << ", " << stats.lookup_misses << " missed the last region, "
+           << stats.unresolved << " unresolved" << endl;
+    logger << "#Tables: " << n_modules - 1 << " modules, " << regions << " regions, " << n_tb_descs << " TB descriptors, "
+           << edges << " edges in " << edge_slots << " slots, " << tb_counters << " TB counters, " << first_hits << " timeline events" << endl;
+    logger << "#Save phases (ms): gather " << stats.gather_ns / 1e6 << ", collect " << stats.collect_ns / 1e6
+           << ", digest " << stats.digest_ns / 1e6 << ", segment " << stats.segment_ns / 1e6 << ", merge " << stats.merge_ns / 1e6
+           << ", read old " << stats.read_old_ns / 1e6 << ", write " << stats.write_ns / 1e6 << endl;
     
-    if(is64Bit(eh)){
-		Elf64_Ehdr eh64;	/* elf-header is fixed size */
-		Elf64_Shdr* sh_tbl;	/* section-header table is variable size */
-
-		read_elf_header64(elffd, &eh64);
-
-		/* Section header table :  */
-		sh_tbl = (Elf64_Shdr*) malloc(eh64.e_shentsize * eh64.e_shnum);
-		read_section_header_table64(elffd, eh64, sh_tbl);
-		
-		for (int i = 0; i < eh64.e_shnum; ++i) {
-		    int flag = sh_tbl[i].sh_flags;
-		    // 0x2: SHF_ALLOC
-		    // 0x4: SHF_EXECINSTR
-		    // See: https://docs.oracle.com/cd/E19120-01/open.solaris/819-0690/6n33n7fcj/index.html
-		    if ((flag & 0x2) && (flag & 0x4)) {
-		        base_address = sh_tbl[i].sh_addr - sh_tbl[i].sh_offset;
-		        break;
-		    }
-		}
-		free(sh_tbl);
-	} else{
-		Elf32_Shdr* sh_tbl = (Elf32_Shdr*) malloc(eh.e_shentsize * eh.e_shnum);
-		read_section_header_table(elffd, eh, sh_tbl);
-		
-		for (int i = 0; i < eh.e_shnum; ++i) {
-		    int flag = sh_tbl[i].sh_flags;
-		    // 0x2: SHF_ALLOC
-		    // 0x4: SHF_EXECINSTR
-		    // See: https://docs.oracle.com/cd/E19120-01/open.solaris/819-0690/6n33n7fcj/index.html
-		    if ((flag & 0x2) && (flag & 0x4)) {
-		        base_address = sh_tbl[i].sh_addr - sh_tbl[i].sh_offset;
-		        break;
-		    }
-		}
-		free(sh_tbl);
-	}
-	
-	close(elffd);
-	
-	logger << "Base Address parsed @0x" << hex << base_address << dec << endl;
-	
-	return base_address;
+    ostringstream json;
+    json << "{\"pid\":" << getpid() << ",\"binary\":" << json_string(*target_filename)
+         << ",\"exec\":\"" << exec_names[exec_mode] << "\",\"vcpus\":" << n_vcpus
+         << ",\"callbacks\":" << callbacks << ",\"discovered\":" << discovered
+         << ",\"tbs_translated\":" << stats.tbs_translated << ",\"tbs_rejected\":" << stats.tbs_rejected
+         << ",\"insns_translated\":" << stats.insns_translated << ",\"insns_instrumented\":" << stats.insns_instrumented
+         << ",\"lookups\":" << stats.lookups << ",\"lookup_misses\":" << stats.lookup_misses << ",\"unresolved\":" << stats.unresolved
+         << ",\"modules\":" << n_modules - 1 << ",\"regions\":" << regions << ",\"tb_descs\":" << n_tb_descs
+         << ",\"edges\":" << edges << ",\"edge_slots\":" << edge_slots << ",\"tb_counters\":" << tb_counters
+         << ",\"timeline_events\":" << first_hits
+         << ",\"phases_ns\":{\"gather\":" << stats.gather_ns << ",\"collect\":" << stats.collect_ns
+         << ",\"digest\":" << stats.digest_ns << ",\"segment\":" << stats.segment_ns << ",\"merge\":" << stats.merge_ns
+         << ",\"read_old\":" << stats.read_old_ns << ",\"write\":" << stats.write_ns << "}}\n";
+    string line = json.str();
+    int fd = open("capnp-capture.stats.jsonl", O_WRONLY | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd == -1 || write(fd, line.data(), line.size()) != (ssize_t) line.size()) {
+        logger << "Unable to write capnp-capture.stats.jsonl: " << strerror(errno) << endl;
+    }
+    if (fd != -1) {
+        close(fd);
+    }
 }
 
-static void plugin_exit(qemu_plugin_id_t id, void *p)
+/*
+ * Saves one output per module that had any instruction executed
+ * Called at exit, and before an execve while the guest keeps running
+ */
+static void save_capture()
 {
-    // Merge recorded insn and sort them accordingly
-    map<int64_t, int8_t> instructions;
-    for (size_t i = 0; i < insn_executed.size(); ++i) {
-        for (int64_t offset : insn_executed[i]) {
-            instructions.emplace(offset, insn_discovered[offset]);
+    lock_guard<mutex> save_guard(save_lock);
+    lock_guard<mutex> log_guard(log_lock);
+    
+    stats.gather_ns = stats.collect_ns = stats.digest_ns = stats.segment_ns = 0;
+    stats.merge_ns = stats.read_old_ns = stats.write_ns = 0;
+    uint64_t start = monotonic_ns();
+    if (record_counts) {
+        gather_counts();
+    }
+    if (record_edges) {
+        gather_edges();
+    }
+    if (record_functions) {
+        gather_functions();
+    }
+    for (uint32_t id = 1; id < n_modules.load(memory_order_acquire); ++id) {
+        module_t * module = modules[id].load(memory_order_acquire);
+        if (module->ready.load(memory_order_acquire)) {
+            fold_hits(module->coverage);
         }
     }
+    if (output_mode == 2) {
+        gather_blocks();
+    }
+    if (record_data) {
+        gather_data();
+    }
+    if (verify_code) {
+        gather_modified();
+    }
+    if (timeline_clock != TIMELINE_NONE) {
+        gather_timeline();
+    }
+    stats.gather_ns = monotonic_ns() - start;
     
-    // Save file is base name + .capnp.out
-	string output(strrchr(target_filename->c_str(), '/') + 1);
-	output += ".capnp.out";
-	logger << "Saving output to " << output << endl;
-    
-    int64_t base_address = -1;
-    if (output_version == 0) {
-        base_address = parse_base_address();
-        if (!write_version_0(output.c_str(), instructions, base_address)) {
-            logger << "Failed to write to output file" << endl;
+    // The target is always written, so that an existing capture is still refreshed
+    for (uint32_t id = 1; id < n_modules.load(memory_order_acquire); ++id) {
+        module_t * module = modules[id].load(memory_order_acquire);
+        coverage_t & coverage = module->coverage;
+        if (!module->ready.load(memory_order_acquire) || !coverage.size) {
+            continue;
         }
-    } else {
-        // Calculate executable digest
-        string digest;
-        string command("md5sum -b ");
-        command += target_filename->c_str();
-        istringstream exec_out(exec(command.c_str()));
-        exec_out >> digest;
-        logger << "Executable MD5 digest: " << digest << endl;
         
-        if (file_exists(output.c_str())) {
-            logger << "Output exists. Loading it." << endl;
-            // base_address = input_version_1(instructions, output.c_str(), digest);
-            string original_digest;
-            map<int64_t, int8_t> original_instructions;
-            if (!read_version_1(output.c_str(), original_instructions, base_address, original_digest)) {
-                logger << "Failed to read from input file" << endl;
-                base_address = -1;
-            } else if (original_digest != digest) {
-                logger << "Digest mismatch, probably due to a recompilation of the file" << endl;
-                logger << "Original output digest: " << original_digest << endl;
-                logger << "Original output will be disposed" << endl;
-                base_address = -1;
-            } else {
-                logger << "Original output digest match" << endl;
-                logger << "Merging two sets of instructions:" << endl;
-                logger << "#Insns captured in this run = " << instructions.size() << endl;
-                logger << "#Insns in the old capture file = " << original_instructions.size() << endl;
-                instructions.insert(original_instructions.begin(), original_instructions.end());
-                logger << "Finished merging" << endl;
-                logger << "#Insns after merging two sets = " << instructions.size() << endl;
+        vector<capture_insn_t> instructions;
+        start = monotonic_ns();
+        collect_instructions(coverage, instructions);
+        stats.collect_ns += monotonic_ns() - start;
+        if (!instructions.empty() || module == target_module) {
+            save_module(module, instructions);
+        }
+        // Gathered again from the vCPUs and descriptors on the next save
+        module->details = capture_details_t();
+    }
+    
+    report_stats();
+}
+
+/*
+ * Drops the execution counts that were saved (before an execve) or belong to the parent
+ * (after a fork), so that they are not counted twice
+ */
+static void reset_counts()
+{
+    for (atomic<vcpu_state_t *> & chunk : vcpu_chunks) {
+        vcpu_state_t * states = chunk.load();
+        for (size_t i = 0; states && i < VCPU_CHUNK_SIZE; ++i) {
+            lock_guard<mutex> guard(states[i].grow_lock);
+            // The keys stay, the vCPU would insert them again anyway
+            for (auto & slot : states[i].tb_counts.slots) {
+                slot.second = 0;
             }
         }
-        if (base_address == -1) {
-            base_address = parse_base_address();
+    }
+    for (uint32_t id = 1; id < n_modules.load(memory_order_acquire); ++id) {
+        module_t * module = modules[id].load(memory_order_acquire);
+        coverage_t & coverage = module->coverage;
+        if (module->ready.load(memory_order_acquire) && coverage.hits) {
+            // Private anonymous pages read back as zero once dropped
+            madvise(coverage.hits, coverage.size * sizeof(uint64_t), MADV_DONTNEED);
         }
-        if (!write_version_1(output.c_str(), instructions, base_address, digest)) {
-            logger << "Failed to write to output file" << endl;
+    }
+}
+
+template <typename F>
+static void for_each_vcpu_lock(F f)
+{
+    for (atomic<vcpu_state_t *> & chunk : vcpu_chunks) {
+        vcpu_state_t * states = chunk.load();
+        for (size_t i = 0; states && i < VCPU_CHUNK_SIZE; ++i) {
+            f(states[i].grow_lock);
         }
     }
+}
+
+static void fork_prepare()
+{
+    // Neither does the digest thread, the child would wait for its digest forever
+    join_digest_thread();
+    // The checkpoint thread does not survive the fork, it must not hold either lock
+    // Same order as the save path
+    save_lock.lock();
+    log_lock.lock();
+    // No vCPU may be reallocating its containers either, holding vcpu_chunks_lock keeps the set fixed
+    vcpu_chunks_lock.lock();
+    for_each_vcpu_lock([](mutex & lock) { lock.lock(); });
+}
+
+static void fork_unlock()
+{
+    for_each_vcpu_lock([](mutex & lock) { lock.unlock(); });
+    vcpu_chunks_lock.unlock();
+    log_lock.unlock();
+    save_lock.unlock();
+}
+
+static void fork_parent()
+{
+    fork_unlock();
+}
+
+/*
+ * Runs in the child on the forking vCPU thread, while QEMU still holds its own locks
+ * The checkpoint thread of the parent does not exist here, so a new one is started
+ */
+static void fork_child()
+{
+    fork_unlock();
+    logger << "Forked from " << getppid() << ", now saving as " << getpid() << endl;
+    reset_counts();
+    if (live_export) {
+        fork_live();
+    }
+    if (checkpoint_thread.joinable()) {
+        // Only forgets the parent's thread, there is nothing to join in this process
+        checkpoint_thread.detach();
+        sem_init(&checkpoint_sem, 0, 0);
+        checkpoint_thread = thread(checkpoint_main);
+    }
+}
+
+// Saves the capture and releases everything, once no callback can fire anymore
+static void finish_capture()
+{
+    stop_checkpoint_thread();
+    save_capture();
     
+    join_digest_thread();
+    unlink_live();
+    free_tb_descs();
+    free_modules();
+    free_vcpus();
+    delete region_table.exchange(nullptr);
+    retired_tables.clear();
     logger.close();
 }
 
+static void plugin_exit(qemu_plugin_id_t id, void *p)
+{
+    finish_capture();
+}
+
+static void register_callbacks(qemu_plugin_id_t id)
+{
+    /* Register vCPU, translation block and exit callbacks */
+    qemu_plugin_register_vcpu_init_cb(id, vcpu_init);
+    qemu_plugin_register_vcpu_tb_trans_cb(id, vcpu_tb_trans);
+    if (mapping_syscalls.mmap != -1) {
+        qemu_plugin_register_vcpu_syscall_cb(id, vcpu_syscall);
+        qemu_plugin_register_vcpu_syscall_ret_cb(id, vcpu_syscall_ret);
+    }
+    qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
+}
+
+/**
+ * saturate=<N>: called once qemu_plugin_reset() has dropped all callbacks, the exit callback
+ * included, so the capture is saved here and nothing gets registered again
+ */
+static void plugin_saturated(qemu_plugin_id_t id)
+{
+    // Runs while all vCPUs are stopped, the checkpoint thread may still log
+    {
+        lock_guard<mutex> guard(log_lock);
+        logger << "No new instruction for " << saturate_insns << " guest instructions, saving and detaching" << endl;
+    }
+    finish_capture();
+    if (saturate_exit) {
+        // Skips QEMU's exit handlers, which must not run from a vCPU thread in an exclusive section
+        _exit(0);
+    }
+}
+
+/**
+ * Called once qemu_plugin_reset() has dropped all callbacks and flushed the TB cache
+ */
+static void plugin_reinstall(qemu_plugin_id_t id)
+{
+    if (saturated) {
+        // Saturation was reached while this flush was pending
+        plugin_saturated(id);
+        return;
+    }
+    // Runs while all vCPUs are stopped
+    {
+        lock_guard<mutex> guard(log_lock);
+        logger << "TB cache flushed after " << quiet_tbs << " TBs went quiet" << endl;
+    }
+    quiet_threshold = quiet_threshold * 2;
+    quiet_tbs = 0;
+    flush_pending = false;
+    register_callbacks(id);
+}
+
 /**
  * Install the plugin
  */
@@ -289,14 +2433,6 @@ QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id,
                                            const qemu_info_t *info, int argc,
                                            char **argv)
 {
-    /*
-     * Initialize dynamic array to cache vCPU instruction.
-     * This could be huge and is not limited to thread::hardware_concurrency() - QEMU spawns 1 vcpu per
-     * thread, regardless of how many CPUs the host has.
-     * FIXME: Set to 255 as a temporary resolution
-     */
-    insn_executed.resize(255);
-    
     if (argc == 0) {
         cerr << "Expect at least 1 argument 'binary=<binary_file_location>'\n";
         return -1;
@@ -310,20 +2446,222 @@ QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id,
     // argv[2]: mode=0 (default, output capnp-serialized instruction offset table)
     //               1 (output .txt format of human-readable disassembly result)
     //               2 (output qemu translation block addresses (not just those instructions being actually translated)
+    //                  into CaptureResult.blocks, needs version=1)
+    // Options after binary= are matched by name, so their order does not matter:
+    //   modules=target (default, only record the binary given in binary=)
+    //           all    (record every mapped file, one output per file)
+    //   counts=1 (also record execution counts, needs version=1, and exec=tb or exec=inline)
+    //   edges=1  (also record taken control transfers between TBs, needs version=1 and exec=tb)
+    //   functions=1 (also record call targets as function starts, needs exec=tb)
+    //   data=1   (also record loads from executable sections, needs version=1)
+    //   verify=1 (also flag instructions whose translated bytes differ from the file, needs version=1)
+    //   live=1   (publish the executed bitsets in shared memory, see live_coverage)
+    //   extents=1 (store instructions as runs of contiguous instructions, much smaller, needs version=1)
+    //   include=<name>[:<name>...] (only record these sections (e.g. .text) and symbols)
+    //   exclude=<name>[:<name>...] (never record these sections and symbols)
+    //   timeline=insns (also record when each instruction was first executed, in guest instructions)
+    //            time  (same, in nanoseconds)
+    //   saturate=<N>     (save and detach once N guest instructions ran without a new one recorded)
+    //   saturate_exit=1  (also terminate the guest when detaching)
+    //   checkpoint=<seconds>  (append new instructions to <output>.<pid>.ckpt periodically)
+    //   checkpoint_signal=1   (also checkpoint on SIGUSR1)
+    //   digest=md5   (default, same digest as md5sum)
+    //          xxh64 (faster digest for large binaries)
+    //   exec=insn   (default, one callback per executed instruction)
+    //        tb     (one callback per executed translation block)
+    //        inline (no callback, inline counter per instruction)
+    //        once   (per TB callback until recorded, then none after the next TB cache flush)
     char * filename = strchr(argv[0], '=') + 1;
     // DEBUG
     logger << "Tracing " << filename << endl;
-    auto [it, n] = filename_table.emplace(filename);
-    target_filename = &*it;
+    {
+        lock_guard<mutex> guard(region_lock);
+        target_module = get_module(filename);
+        target_filename = &target_module->filename;
+    }
     
-    if (argc > 1) {
-        output_version = atoi(strchr(argv[1], '=') + 1);
+    for (int i = 1; i < argc; ++i) {
+        char * value = strchr(argv[i], '=');
+        if (!value) {
+            cerr << "Malformed argument '" << argv[i] << "', expect <key>=<value>\n";
+            return -1;
+        }
+        string key(argv[i], value - argv[i]);
+        ++value;
+        
+        if (key == "version") {
+            output_version = atoi(value);
+        } else if (key == "mode") {
+            output_mode = atoi(value);
+        } else if (key == "modules") {
+            all_modules = !strcmp(value, "all");
+        } else if (key == "counts") {
+            record_counts = atoi(value);
+        } else if (key == "edges") {
+            record_edges = atoi(value);
+        } else if (key == "functions") {
+            record_functions = atoi(value);
+        } else if (key == "data") {
+            record_data = atoi(value);
+        } else if (key == "verify") {
+            verify_code = atoi(value);
+        } else if (key == "live") {
+            live_export = atoi(value);
+        } else if (key == "extents") {
+            write_extents = atoi(value);
+        } else if (key == "include" || key == "exclude") {
+            // Commas separate the plugin arguments, so names are separated by colons
+            unordered_set<string> & names = key == "include" ? include_names : exclude_names;
+            for (char * name = strtok(value, ":"); name; name = strtok(nullptr, ":")) {
+                names.insert(name);
+            }
+        } else if (key == "timeline") {
+            if (!strcmp(value, "insns")) {
+                timeline_clock = TIMELINE_INSNS;
+            } else if (!strcmp(value, "time")) {
+                timeline_clock = TIMELINE_TIME;
+            } else if (strcmp(value, "0")) {
+                cerr << "Unknown timeline clock '" << value << "'\n";
+                return -1;
+            }
+        } else if (key == "saturate") {
+            saturate_insns = strtoull(value, nullptr, 10);
+        } else if (key == "saturate_exit") {
+            saturate_exit = atoi(value);
+        } else if (key == "checkpoint") {
+            checkpoint_interval = atoi(value);
+        } else if (key == "checkpoint_signal") {
+            checkpoint_on_signal = atoi(value);
+        } else if (key == "digest") {
+            if (!strcmp(value, "md5")) {
+                digest_algorithm = DIGEST_MD5;
+            } else if (!strcmp(value, "xxh64")) {
+                digest_algorithm = DIGEST_XXH64;
+            } else {
+                cerr << "Unknown digest algorithm '" << value << "'\n";
+                return -1;
+            }
+        } else if (key == "exec") {
+            if (!strcmp(value, "insn")) {
+                exec_mode = EXEC_INSN;
+            } else if (!strcmp(value, "tb")) {
+                exec_mode = EXEC_TB;
+            } else if (!strcmp(value, "inline")) {
+                exec_mode = EXEC_INLINE;
+            } else if (!strcmp(value, "once")) {
+                exec_mode = EXEC_ONCE;
+            } else {
+                cerr << "Unknown exec mode '" << value << "'\n";
+                return -1;
+            }
+        } else {
+            logger << "Ignoring unknown argument " << argv[i] << endl;
+        }
     }
     logger << "Output Version " << output_version << endl;
+    if (output_mode == 2 && output_version == 0) {
+        logger << "Translation blocks can only be stored with version=1, ignoring mode=2" << endl;
+        output_mode = 0;
+    } else if (output_mode != 0 && output_mode != 2) {
+        logger << "Mode " << output_mode << " is not implemented, ignoring it" << endl;
+        output_mode = 0;
+    }
+    // Version 0 has no room for these, they would only cost instrumentation
+    if (output_version == 0) {
+        if (record_counts) {
+            logger << "Execution counts can only be stored with version=1, ignoring counts=1" << endl;
+            record_counts = false;
+        }
+        if (record_edges) {
+            logger << "Control-flow edges can only be stored with version=1, ignoring edges=1" << endl;
+            record_edges = false;
+        }
+        if (record_data) {
+            logger << "Code read as data can only be stored with version=1, ignoring data=1" << endl;
+            record_data = false;
+        }
+        if (verify_code) {
+            logger << "Modified instructions can only be stored with version=1, ignoring verify=1" << endl;
+            verify_code = false;
+        }
+    }
+    if (record_counts && (exec_mode == EXEC_INSN || exec_mode == EXEC_ONCE)) {
+        logger << "Execution counts need callbacks on every TB execution, switching to exec=tb" << endl;
+        exec_mode = EXEC_TB;
+    } else if (record_counts && exec_mode == EXEC_INLINE) {
+        logger << "Execution counts of exec=inline may be lost when guest threads run in parallel, exec=tb counts exactly" << endl;
+    }
+    if (record_edges && exec_mode != EXEC_TB) {
+        logger << "Control-flow edges need callbacks on every TB execution, switching to exec=tb" << endl;
+        exec_mode = EXEC_TB;
+    }
+    if (record_functions && exec_mode != EXEC_TB) {
+        logger << "Function starts need callbacks on every TB execution, switching to exec=tb" << endl;
+        exec_mode = EXEC_TB;
+    }
+    if (timeline_clock != TIMELINE_NONE && output_version == 0) {
+        logger << "The timeline can only be stored with version=1, ignoring timeline=" << endl;
+        timeline_clock = TIMELINE_NONE;
+    }
+    if (live_export && exec_mode == EXEC_INLINE) {
+        // Inline adds only reach the bitset when the counters are folded at a save
+        logger << "Live coverage needs the executed bitset filled as code runs, switching to exec=tb" << endl;
+        exec_mode = EXEC_TB;
+    }
+    if (timeline_clock != TIMELINE_NONE && exec_mode == EXEC_INLINE) {
+        logger << "The timeline needs to see new instructions as they run, switching to exec=tb" << endl;
+        exec_mode = EXEC_TB;
+    }
+    if (saturate_insns && exec_mode == EXEC_INLINE) {
+        logger << "Saturation needs to see new instructions as they run, switching to exec=tb" << endl;
+        exec_mode = EXEC_TB;
+    }
+    const char * exec_names[] = { "per instruction", "per TB", "inline counters", "first execution only" };
+    logger << "Execution tracking: " << exec_names[exec_mode] << endl;
+    
+    timeline_start = monotonic_ns();
+    if (!get_coverage(target_module).size) {
+        cerr << "Unable to set up coverage tables for " << filename << "\n";
+        return -1;
+    }
+    logger << "Recording " << (all_modules ? "every mapped file" : "the target only") << endl;
+    if (saturate_insns) {
+        logger << "Detaching after " << saturate_insns << " guest instructions without a new one"
+               << (saturate_exit ? ", then terminating the guest" : "") << endl;
+    }
+    
+    // Hash the target while the guest runs, the result is only needed at exit
+    digest_thread = thread(module_digest, target_module);
+    
+    if (checkpoint_interval || checkpoint_on_signal) {
+        sem_init(&checkpoint_sem, 0, 0);
+        checkpoint_thread = thread(checkpoint_main);
+        logger << "Checkpointing every " << checkpoint_interval << "s"
+               << (checkpoint_on_signal ? " and on SIGUSR1" : "") << endl;
+    }
 
-    /* Register translation block and exit callbacks */
-    qemu_plugin_register_vcpu_tb_trans_cb(id, vcpu_tb_trans);
-    qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
+    // Syscall numbers of the guest ABI, see arch/*/entry/syscalls in the Linux tree
+    if (!info->system_emulation && !strcmp(info->target_name, "x86_64")) {
+        mapping_syscalls = { 9, 11, 25 };
+        exec_syscalls = { 59, 322 };
+        is_call = is_call_x86_64;
+    } else if (!info->system_emulation && !strcmp(info->target_name, "aarch64")) {
+        mapping_syscalls = { 222, 215, 216 };
+        exec_syscalls = { 221, 281 };
+        is_call = is_call_aarch64;
+    } else {
+        logger << "Mapping syscalls unknown for " << info->target_name
+               << ", mappings created after the first translation and captures of exec'ed processes are missed" << endl;
+        if (record_functions) {
+            logger << "Call instructions unknown for " << info->target_name << ", no function starts recorded" << endl;
+        }
+    }
+    
+    // QEMU user mode forks the host process along with the guest
+    pthread_atfork(fork_prepare, fork_parent, fork_child);
+    
+    plugin_id = id;
+    register_callbacks(id);
 
     return 0;
 }
@@ -0,0 +1,104 @@
+/**
+ * This program prints the coverage of a running capture, as published by capnp-capture with live=1
+ * It only reads the shared executed bitsets, so the traced program is never paused
+ */
+// Example: ./live_coverage $(pgrep -f qemu-x86_64) 10
+
+#include "live_coverage.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <signal.h>
+#include <unistd.h>
+
+using namespace std;
+
+struct segment_t {
+    const live_header_t * header = nullptr;
+    size_t bytes = 0;
+    uint64_t last = 0;      // executed instructions at the previous sample
+};
+
+// Maps the segments of pid that appeared since the last call, keyed by name
+static void open_segments(pid_t pid, map<string, segment_t> & segments)
+{
+    glob_t matches;
+    string pattern = string("/dev/shm") + LIVE_COVERAGE_PREFIX + to_string(pid) + ".*";
+    if (glob(pattern.c_str(), 0, nullptr, &matches) != 0) {
+        return;
+    }
+    for (size_t i = 0; i < matches.gl_pathc; ++i) {
+        string name = matches.gl_pathv[i] + strlen("/dev/shm");
+        if (segments.count(name)) {
+            continue;
+        }
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        struct stat segment_status;
+        if (fd == -1 || fstat(fd, &segment_status) == -1 || segment_status.st_size < (off_t) sizeof(live_header_t)) {
+            if (fd != -1) close(fd);
+            continue;
+        }
+        void * mem = mmap(nullptr, segment_status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED) {
+            perror("Error mapping shared memory segment");
+            continue;
+        }
+        const live_header_t * header = (const live_header_t *) mem;
+        if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != LIVE_COVERAGE_MAGIC) {
+            // Not initialised yet, try again at the next sample
+            munmap(mem, segment_status.st_size);
+            continue;
+        }
+        segments[name] = { header, (size_t) segment_status.st_size, 0 };
+    }
+    globfree(&matches);
+}
+
+static uint64_t count_executed(const live_header_t * header)
+{
+    const uint64_t * words = (const uint64_t *) (header + 1);
+    uint64_t executed = 0;
+    for (size_t w = 0; w < (header->size + 63) / 64; ++w) {
+        executed += __builtin_popcountll(__atomic_load_n(&words[w], __ATOMIC_RELAXED));
+    }
+    return executed;
+}
+
+int main(int argc, char ** argv) {
+    if (argc < 2) {
+        cout << "Usage: ./live_coverage <qemu_pid> [interval_seconds]" << endl;
+        exit(-1);
+    }
+    pid_t pid = atoi(argv[1]);
+    unsigned interval = argc > 2 ? max(1, atoi(argv[2])) : 5;
+
+    map<string, segment_t> segments;
+    for (unsigned elapsed = 0; kill(pid, 0) == 0; elapsed += interval) {
+        // The plugin removes its segments at exit, their mappings here stay readable
+        bool published = segments.empty();
+        for (const auto & [name, segment] : segments) {
+            published |= access(("/dev/shm" + name).c_str(), F_OK) == 0;
+        }
+        if (!published) {
+            break;
+        }
+        open_segments(pid, segments);
+        if (segments.empty()) {
+            cout << "# No live coverage published by " << pid << " yet (is it running with live=1?)" << endl;
+        }
+        for (auto & [name, segment] : segments) {
+            uint64_t executed = count_executed(segment.header);
+            cout << elapsed << "s " << segment.header->filename << ": " << executed << " instructions, +"
+                 << executed - segment.last << " (" << (double) (executed - segment.last) / interval << "/s)" << endl;
+            segment.last = executed;
+        }
+        sleep(interval);
+    }
+    cout << "# Capture of process " << pid << " is over" << endl;
+
+    for (auto & [name, segment] : segments) {
+        munmap((void *) segment.header, segment.bytes);
+    }
+}
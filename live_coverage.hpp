@@ -0,0 +1,26 @@
+#ifndef _LIVE_COVERAGE_HPP_
+#define _LIVE_COVERAGE_HPP_
+
+#include <bits/stdc++.h>
+
+// Layout of the shared memory segments published by capnp-capture with live=1, one per recorded file
+// The header fills the first page, the executed bitset of the file (one bit per offset) follows it
+// Segments are named /capnp-capture.<pid>.<module id> and removed when the plugin exits
+
+#define LIVE_COVERAGE_MAGIC 0x564f43504e504143ull   // "CAPNPCOV"
+#define LIVE_COVERAGE_PREFIX "/capnp-capture."
+
+struct live_header_t {
+    uint64_t magic;         // set last, once the rest of the header is valid
+    uint64_t size;          // file size, the bitset has (size + 63) / 64 words
+    int64_t pid;            // QEMU process that created the segment, forked children included
+    char filename[4072];
+};
+static_assert(sizeof(live_header_t) == 4096, "the bitset must start on a page boundary");
+
+inline std::string live_coverage_name(pid_t pid, uint32_t module_id)
+{
+    return LIVE_COVERAGE_PREFIX + std::to_string(pid) + "." + std::to_string(module_id);
+}
+
+#endif
@@ -47,13 +47,18 @@ int main(int argc, char ** argv) {
     
     // Open capnproto capture file
     map<int64_t, int8_t> dynamic_offsets;
+    capture_details_t details;
+    const map<int64_t, uint64_t> & counts = details.counts;
     int64_t base_address;
     string digest;
-    read_version_1(argv[2], dynamic_offsets, base_address, digest);
+    read_version_1(argv[2], dynamic_offsets, base_address, digest, details);
     of << "# " << endl;
     of << "# Original binary digest = " << digest << endl;
     of << "# Base address = 0x" << hex << base_address << dec << endl;
     of << "# Finished reading. Total #records = " << dynamic_offsets.size() << endl;
+    if (!counts.empty()) {
+        of << "# Execution counts recorded, shown in front of each instruction" << endl;
+    }
     
     int64_t max_address = dynamic_offsets.rbegin()->first + base_address;
     int8_t num_digits = 0;
@@ -67,6 +72,11 @@ int main(int argc, char ** argv) {
         max_length = max(max_length, length);
     }
     
+    size_t count_digits = 0;
+    for (auto [offset, count] : counts) {
+        count_digits = max(count_digits, to_string(count).size());
+    }
+    
     // Disassemble
     for (auto [offset, length] : dynamic_offsets) {
         ZydisDisassembledInstruction instruction;
@@ -79,6 +89,19 @@ int main(int argc, char ** argv) {
            /* length:          */ length, 
            /* instruction:     */ &instruction 
         ))) {
+            // Mark function starts, if any were recorded
+            if (details.functions.count(offset)) {
+                of << "# function" << endl;
+            }
+            // Mark instructions executed from other bytes than the file's, the disassembly is unreliable
+            if (details.modified.count(offset)) {
+                of << "# modified at runtime" << endl;
+            }
+            // Print execution count, if any were recorded
+            if (count_digits) {
+                auto count = counts.find(offset);
+                of << setw(count_digits) << (count == counts.end() ? 0 : count->second) << "  ";
+            }
             // Print runtime address
             of << setw(num_digits) << hex << runtime_addr << ": ";
             // Print raw bytes, still in hex mode
@@ -95,6 +118,53 @@ int main(int argc, char ** argv) {
         }
     }
     
+    // Print control-flow edges, if any were recorded
+    if (!details.edges.empty()) {
+        of << "# " << endl;
+        of << "# Control-flow edges = " << details.edges.size() << endl;
+        for (auto [source, target] : details.edges) {
+            of << "# " << hex << source + base_address << " -> " << target + base_address << dec << endl;
+        }
+    }
+    
+    // Print code read as data, if any was recorded
+    if (!details.data.empty()) {
+        of << "# " << endl;
+        of << "# Code ranges read as data = " << details.data.size() << endl;
+        for (auto [begin, end] : details.data) {
+            of << "# " << hex << begin + base_address << " - " << end + base_address << dec << " (" << end - begin << " bytes)" << endl;
+        }
+    }
+    
+    // Print translation blocks, if any were recorded
+    if (!details.blocks.empty()) {
+        size_t executed = 0;
+        for (const auto & [block, was_executed] : details.blocks) {
+            executed += was_executed;
+        }
+        of << "# " << endl;
+        of << "# Translation blocks = " << details.blocks.size() << ", " << executed << " of them executed" << endl;
+        for (const auto & [block, was_executed] : details.blocks) {
+            of << "# " << hex << get<0>(block) + base_address << dec << ": " << get<1>(block) << " instructions, "
+               << get<2>(block) << " bytes" << (was_executed ? "" : ", never executed") << endl;
+        }
+    }
+    
+    // Print the cumulative coverage curve, if a timeline was recorded
+    if (!details.timeline.empty()) {
+        const auto & timeline = details.timeline;
+        const char * unit = details.timeline_in_ns ? " ns" : " guest instructions";
+        of << "# " << endl;
+        of << "# Coverage growth, " << timeline.size() << " instructions over " << timeline.back().second << unit << endl;
+        // About 100 points of the curve, the last one included
+        size_t step = max<size_t>(1, timeline.size() / 100);
+        for (size_t i = 0; i < timeline.size(); i += step) {
+            size_t n = min(i + step, timeline.size());
+            of << "# " << timeline[n - 1].second << unit << ": " << n << " instructions ("
+               << fixed << setprecision(1) << 100.0 * n / timeline.size() << "%)" << defaultfloat << endl;
+        }
+    }
+    
     // Free resources
     if (munmap(exe, exe_size) == -1) {
         perror("Error unmapping executable file");
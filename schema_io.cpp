@@ -1,6 +1,24 @@
 #include "schema_io.hpp"
 
 namespace std {   
+    void add_data_range(
+        map<int64_t, int64_t> & ranges,
+        int64_t begin,
+        int64_t end
+    ) {
+        // First range that may touch [begin, end) is the last one starting at or before begin
+        auto it = ranges.upper_bound(begin);
+        if (it != ranges.begin() && prev(it)->second >= begin) {
+            --it;
+        }
+        while (it != ranges.end() && it->first <= end) {
+            begin = min(begin, it->first);
+            end = max(end, it->second);
+            it = ranges.erase(it);
+        }
+        ranges.emplace(begin, end);
+    }
+    
     static int open_file(const char * file, bool is_writing = false) {
         DEBUG_PRINT("Reading capnproto serialized file from: " << argv[1]);
         int fd;
@@ -34,12 +52,22 @@ namespace std {
         return true;
     }
     
+    static int64_t insn_offset(const pair<const int64_t, int8_t> & insn) {
+        return insn.first;
+    }
+    
+    static int64_t insn_offset(const capture_insn_t & insn) {
+        return insn.offset;
+    }
+    
     // Base address will be added to all entries written
     // This is for compatibility purpose
-    bool write_version_0(
+    template<typename Instructions>
+    static bool write_analysis(
         const char * file,
-        map<int64_t, int8_t> & instructions,
-        int64_t base_address = 0
+        const Instructions & instructions,
+        int64_t base_address,
+        const set<int64_t> * functions
     ) {
         int fd = open_file(file, true);
         if (fd == -1) return false;
@@ -51,67 +79,663 @@ namespace std {
         
         size_t i = 0;
         for (const auto & insn : instructions) {
-            offsets.set(i, insn.first + base_address);
+            offsets.set(i, insn_offset(insn) + base_address);
             ++i;
         }
         
+        if (functions) {
+            auto func = analysis_rst.initFuncStarts().initFunc(functions->size());
+            i = 0;
+            for (int64_t offset : *functions) {
+                func.set(i, offset + base_address);
+                ++i;
+            }
+        }
+        
         writeMessageToFd(fd, message);
         
         close(fd);
         return true;
     }
     
-    bool read_version_1(
+    bool write_version_0(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t base_address = 0
+    ) {
+        return write_analysis(file, instructions, base_address, nullptr);
+    }
+    
+    bool write_version_0(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t base_address,
+        const set<int64_t> & functions
+    ) {
+        return write_analysis(file, instructions, base_address, &functions);
+    }
+    
+    bool write_version_0(
+        const char * file,
+        const vector<capture_insn_t> & instructions,
+        int64_t base_address,
+        const set<int64_t> & functions
+    ) {
+        return write_analysis(file, instructions, base_address, &functions);
+    }
+    
+    // A version 1 file is a sequence of one or more CaptureResult messages (one for a final
+    // capture, one per checkpoint for an incremental one), mapped in memory with a reader per message
+    // A truncated trailing message, left by a process killed while appending, is ignored
+    class mapped_capture_t {
+    public:
+        vector<unique_ptr<::capnp::FlatArrayMessageReader>> messages;
+        
+        bool open(const char * file) {
+            int fd = open_file(file);
+            if (fd == -1) return false;
+            
+            struct stat file_status;
+            if (fstat(fd, &file_status) == -1 || file_status.st_size < (off_t) sizeof(::capnp::word)) {
+                close(fd);
+                return false;
+            }
+            size = file_status.st_size;
+            data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (data == MAP_FAILED) {
+                perror("Error in mapping capnproto serialized file");
+                return false;
+            }
+            madvise(data, size, MADV_SEQUENTIAL);
+            
+            // Our own captures are trusted, and large binaries easily exceed the default traversal limit
+            ::capnp::ReaderOptions options;
+            options.traversalLimitInWords = kj::maxValue;
+            kj::ArrayPtr<const ::capnp::word> words((const ::capnp::word *) data, size / sizeof(::capnp::word));
+            try {
+                while (words.size() > 0) {
+                    messages.emplace_back(new ::capnp::FlatArrayMessageReader(words, options));
+                    words = kj::arrayPtr(messages.back()->getEnd(), words.end());
+                }
+            } catch (kj::Exception & e) {
+                DEBUG_PRINT("Ignoring truncated message in " << file);
+            }
+            return !messages.empty();
+        }
+        
+        CaptureResult::Reader get(size_t i) {
+            return messages[i]->getRoot<CaptureResult>();
+        }
+        
+        ~mapped_capture_t() {
+            messages.clear();
+            if (data != MAP_FAILED) {
+                munmap(data, size);
+            }
+        }
+        
+    private:
+        void * data = MAP_FAILED;
+        size_t size = 0;
+    };
+    
+    static void read_header(CaptureResult::Reader result, int64_t & base_address, string & digest) {
+        digest = result.getDigest().cStr();
+        if (result.getDigestAlgorithm() == DigestAlgorithm::XXH64) {
+            digest = XXH64_DIGEST_PREFIX + digest;
+        }
+        base_address = result.getBaseAddress();
+    }
+    
+    static void read_details(CaptureResult::Reader result, capture_details_t & details) {
+        for (const auto & edge : result.getEdges()) {
+            details.edges.emplace(edge.getSource(), edge.getTarget());
+        }
+        for (int64_t offset : result.getFunctions()) {
+            details.functions.insert(offset);
+        }
+        for (int64_t offset : result.getModified()) {
+            details.modified.insert(offset);
+        }
+        for (const auto & range : result.getData()) {
+            add_data_range(details.data, range.getOffset(), range.getOffset() + range.getSize());
+        }
+        for (const auto & block : result.getBlocks()) {
+            details.blocks[{ block.getOffset(), block.getInstructions(), block.getSize() }] |= block.getExecuted();
+        }
+        if (details.timeline.empty() && result.hasTimeline()) {
+            auto timeline = result.getTimeline();
+            auto offsets = timeline.getOffsets();
+            auto deltas = timeline.getDeltas();
+            uint64_t clock = 0;
+            details.timeline_in_ns = timeline.getClock() == Timeline::Clock::NANOSECONDS;
+            details.timeline.reserve(min(offsets.size(), deltas.size()));
+            for (size_t i = 0; i < offsets.size() && i < deltas.size(); ++i) {
+                clock += deltas[i];
+                details.timeline.emplace_back(offsets[i], clock);
+            }
+        }
+    }
+    
+    // The instructions of all messages are merged, and optional parts as well when details is given
+    static bool read_capture(
         const char * file,
         map<int64_t, int8_t> & instructions,
         int64_t & base_address,
-        string & digest
+        string & digest,
+        capture_details_t * details
     ) {
-        int fd = open_file(file);
-        if (fd == -1) return false;
+        mapped_capture_t capture;
+        if (!capture.open(file)) return false;
+        
+        read_header(capture.get(0), base_address, digest);
+        for (size_t m = 0; m < capture.messages.size(); ++m) {
+            auto dynamic_result = capture.get(m);
+            for (const auto & insn : dynamic_result.getInstructions()) {
+                instructions[insn.getOffset()] = insn.getLength();
+                if (details && insn.getCount()) {
+                    details->counts[insn.getOffset()] += insn.getCount();
+                }
+            }
+            for (const auto & extent : dynamic_result.getExtents()) {
+                auto lengths = extent.getLengths();
+                auto counts = extent.getCounts();
+                int64_t offset = extent.getOffset();
+                for (size_t i = 0; i < lengths.size(); offset += lengths[i], ++i) {
+                    instructions[offset] = lengths[i];
+                    if (details && i < counts.size() && counts[i]) {
+                        details->counts[offset] += counts[i];
+                    }
+                }
+            }
+            if (details) {
+                read_details(dynamic_result, *details);
+            }
+        }
+        return true;
+    }
+    
+    // A sorted run of instructions, either a flat vector, or the instructions or extents of a mapped message
+    // Extents are walked one instruction at a time: pos is the extent, index and offset the instruction in it
+    struct insn_run_t {
+        const vector<capture_insn_t> * flat = nullptr;
+        ::capnp::List<Instruction>::Reader list;
+        ::capnp::List<Extent>::Reader extents;
+        bool is_extents = false;
+        size_t pos = 0, size = 0, index = 0;
+        int64_t offset = 0;
         
-        ::capnp::StreamFdMessageReader dynamic_message(fd);
-        auto dynamic_result = dynamic_message.getRoot<CaptureResult>();
+        bool done() const {
+            return pos >= size;
+        }
         
-        digest = dynamic_result.getDigest().cStr();
-        base_address = dynamic_result.getBaseAddress();
+        capture_insn_t get() const {
+            if (flat) {
+                return (*flat)[pos];
+            }
+            if (is_extents) {
+                auto extent = extents[pos];
+                auto counts = extent.getCounts();
+                return { offset, (int8_t) extent.getLengths()[index], index < counts.size() ? counts[index] : 0 };
+            }
+            auto insn = list[pos];
+            return { insn.getOffset(), insn.getLength(), insn.getCount() };
+        }
         
-        for (const auto & insn : dynamic_result.getInstructions()) {
-            instructions[insn.getOffset()] = insn.getLength();
+        void next() {
+            if (!is_extents) {
+                ++pos;
+                return;
+            }
+            offset += extents[pos].getLengths()[index];
+            if (++index >= extents[pos].getLengths().size()) {
+                ++pos;
+                index = 0;
+                skip_empty();
+            }
         }
         
-        close(fd);
+        // Moves to the first instruction of the current extent, past extents without any
+        void skip_empty() {
+            while (pos < size && extents[pos].getLengths().size() == 0) {
+                ++pos;
+            }
+            if (pos < size) {
+                offset = extents[pos].getOffset();
+            }
+        }
+    };
+    
+    static insn_run_t flat_run(const vector<capture_insn_t> & instructions) {
+        insn_run_t run;
+        run.flat = &instructions;
+        run.size = instructions.size();
+        return run;
+    }
+    
+    static insn_run_t list_run(::capnp::List<Instruction>::Reader list) {
+        insn_run_t run;
+        run.list = list;
+        run.size = list.size();
+        return run;
+    }
+    
+    static insn_run_t extent_run(::capnp::List<Extent>::Reader extents) {
+        insn_run_t run;
+        run.extents = extents;
+        run.is_extents = true;
+        run.size = extents.size();
+        run.skip_empty();
+        return run;
+    }
+    
+    // Both lists of a message, each sorted on its own
+    static void message_runs(CaptureResult::Reader result, vector<insn_run_t> & runs) {
+        runs.push_back(list_run(result.getInstructions()));
+        runs.push_back(extent_run(result.getExtents()));
+    }
+    
+    /*
+     * k-way merge of sorted runs, emit is called once per distinct offset in order
+     * Counts add up, the length comes from the first run having the offset
+     * A checkpoint file holds one message per checkpoint, so there may be thousands of runs: their
+     * heads are kept in a min-heap, ties broken by run order, and empty or exhausted runs dropped
+     */
+    template<typename Emit>
+    static void merge_runs(vector<insn_run_t> runs, Emit emit) {
+        // Offset of the current instruction of a run, index of the run
+        typedef pair<int64_t, size_t> head_t;
+        priority_queue<head_t, vector<head_t>, greater<head_t>> heads;
+        for (size_t r = 0; r < runs.size(); ++r) {
+            if (!runs[r].done()) {
+                heads.emplace(runs[r].get().offset, r);
+            }
+        }
+        
+        while (!heads.empty()) {
+            int64_t next = heads.top().first;
+            capture_insn_t merged { next, 0, 0 };
+            while (!heads.empty() && heads.top().first == next) {
+                size_t r = heads.top().second;
+                heads.pop();
+                insn_run_t & run = runs[r];
+                for (; !run.done() && run.get().offset == next; run.next()) {
+                    capture_insn_t insn = run.get();
+                    if (!merged.length) {
+                        merged.length = insn.length;
+                    }
+                    merged.count += insn.count;
+                }
+                if (!run.done()) {
+                    heads.emplace(run.get().offset, r);
+                }
+            }
+            emit(merged);
+        }
+    }
+    
+    void merge_instructions(
+        vector<capture_insn_t> & instructions,
+        const vector<capture_insn_t> & other
+    ) {
+        vector<capture_insn_t> merged;
+        merged.reserve(max(instructions.size(), other.size()));
+        merge_runs({ flat_run(instructions), flat_run(other) }, [&](const capture_insn_t & insn) {
+            merged.push_back(insn);
+        });
+        instructions.swap(merged);
+    }
+    
+    bool read_version_1(
+        const char * file,
+        vector<capture_insn_t> & instructions,
+        int64_t & base_address,
+        string & digest,
+        capture_details_t & details
+    ) {
+        mapped_capture_t capture;
+        if (!capture.open(file)) return false;
+        
+        read_header(capture.get(0), base_address, digest);
+        vector<insn_run_t> runs;
+        for (size_t m = 0; m < capture.messages.size(); ++m) {
+            message_runs(capture.get(m), runs);
+            read_details(capture.get(m), details);
+        }
+        instructions.clear();
+        merge_runs(runs, [&](const capture_insn_t & insn) {
+            instructions.push_back(insn);
+        });
         return true;
     }
     
-    bool write_version_1(
+    bool read_header_version_1(
         const char * file,
-        map<int64_t, int8_t> & instructions,
-        int64_t base_address,
+        int64_t & base_address,
         string & digest
     ) {
-        // Create output file, with 644 permission
-        int fd = open_file(file, true);
-        if (fd == -1) return false;
+        mapped_capture_t capture;
+        if (!capture.open(file)) return false;
         
-        // Write to capnp binary output
-        ::capnp::MallocMessageBuilder message;
+        read_header(capture.get(0), base_address, digest);
+        return true;
+    }
+    
+    static CaptureResult::Builder init_capture(
+        ::capnp::MallocMessageBuilder & message,
+        int64_t base_address,
+        string & digest
+    ) {
         auto result = message.initRoot<CaptureResult>();
-        result.setDigest(digest.c_str());
+        if (digest.compare(0, strlen(XXH64_DIGEST_PREFIX), XXH64_DIGEST_PREFIX) == 0) {
+            result.setDigest(digest.c_str() + strlen(XXH64_DIGEST_PREFIX));
+            result.setDigestAlgorithm(DigestAlgorithm::XXH64);
+        } else {
+            result.setDigest(digest.c_str());
+        }
         result.setBaseAddress(base_address);
+        return result;
+    }
+    
+    static void build_details(CaptureResult::Builder result, const capture_details_t & details) {
+        size_t i;
+        if (!details.edges.empty()) {
+            auto output_edges = result.initEdges(details.edges.size());
+            i = 0;
+            for (const auto & edge : details.edges) {
+                output_edges[i].setSource(edge.first);
+                output_edges[i].setTarget(edge.second);
+                ++i;
+            }
+        }
+        
+        if (!details.functions.empty()) {
+            auto output_functions = result.initFunctions(details.functions.size());
+            i = 0;
+            for (int64_t offset : details.functions) {
+                output_functions.set(i, offset);
+                ++i;
+            }
+        }
+        
+        if (!details.modified.empty()) {
+            auto output_modified = result.initModified(details.modified.size());
+            i = 0;
+            for (int64_t offset : details.modified) {
+                output_modified.set(i, offset);
+                ++i;
+            }
+        }
+        
+        if (!details.data.empty()) {
+            auto output_data = result.initData(details.data.size());
+            i = 0;
+            for (const auto & [begin, end] : details.data) {
+                output_data[i].setOffset(begin);
+                output_data[i].setSize(end - begin);
+                ++i;
+            }
+        }
+        
+        if (!details.blocks.empty()) {
+            auto output_blocks = result.initBlocks(details.blocks.size());
+            i = 0;
+            for (const auto & [block, executed] : details.blocks) {
+                output_blocks[i].setOffset(get<0>(block));
+                output_blocks[i].setInstructions(get<1>(block));
+                output_blocks[i].setSize(get<2>(block));
+                output_blocks[i].setExecuted(executed);
+                ++i;
+            }
+        }
         
+        if (!details.timeline.empty()) {
+            auto output_timeline = result.initTimeline();
+            output_timeline.setClock(details.timeline_in_ns ? Timeline::Clock::NANOSECONDS : Timeline::Clock::INSTRUCTIONS);
+            auto offsets = output_timeline.initOffsets(details.timeline.size());
+            auto deltas = output_timeline.initDeltas(details.timeline.size());
+            uint64_t last = 0;
+            for (i = 0; i < details.timeline.size(); ++i) {
+                offsets.set(i, details.timeline[i].first);
+                deltas.set(i, details.timeline[i].second - last);
+                last = details.timeline[i].second;
+            }
+        }
+    }
+    
+    static void build_capture(
+        ::capnp::MallocMessageBuilder & message,
+        map<int64_t, int8_t> & instructions,
+        int64_t base_address,
+        string & digest,
+        const capture_details_t * details
+    ) {
+        auto result = init_capture(message, base_address, digest);
         auto output_insns = result.initInstructions(instructions.size());
         
         size_t i = 0;
         for (const auto & insn : instructions) {
             output_insns[i].setOffset(insn.first);
             output_insns[i].setLength(insn.second);
+            if (details) {
+                auto count = details->counts.find(insn.first);
+                if (count != details->counts.end()) {
+                    output_insns[i].setCount(count->second);
+                }
+            }
             ++i;
         }
         
+        if (details) {
+            build_details(result, *details);
+        }
+    }
+    
+    bool read_version_1(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t & base_address,
+        string & digest
+    ) {
+        return read_capture(file, instructions, base_address, digest, nullptr);
+    }
+    
+    bool read_version_1(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t & base_address,
+        string & digest,
+        capture_details_t & details
+    ) {
+        return read_capture(file, instructions, base_address, digest, &details);
+    }
+    
+    static bool write_capture(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t base_address,
+        string & digest,
+        const capture_details_t * details
+    ) {
+        // Create output file, with 644 permission
+        int fd = open_file(file, true);
+        if (fd == -1) return false;
+        
+        // Write to capnp binary output
+        ::capnp::MallocMessageBuilder message;
+        build_capture(message, instructions, base_address, digest, details);
         writeMessageToFd(fd, message);
         
         close(fd);
         return true;
     }
+    
+    bool write_version_1(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t base_address,
+        string & digest
+    ) {
+        return write_capture(file, instructions, base_address, digest, nullptr);
+    }
+    
+    bool write_version_1(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t base_address,
+        string & digest,
+        const capture_details_t & details
+    ) {
+        return write_capture(file, instructions, base_address, digest, &details);
+    }
+    
+    bool append_version_1(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t base_address,
+        string & digest
+    ) {
+        int fd = open(file, O_WRONLY | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fd == -1) {
+            perror("Error in opening capnproto serialized file");
+            return false;
+        }
+        
+        ::capnp::MallocMessageBuilder message;
+        build_capture(message, instructions, base_address, digest, nullptr);
+        
+        // One write() per message, so that a concurrent reader never sees half of it
+        auto words = ::capnp::messageToFlatArray(message);
+        auto bytes = words.asBytes();
+        bool ok = write(fd, bytes.begin(), bytes.size()) == (ssize_t) bytes.size();
+        
+        close(fd);
+        return ok;
+    }
+    
+    static void set_instruction(Instruction::Builder output, const capture_insn_t & insn) {
+        output.setOffset(insn.offset);
+        output.setLength(insn.length);
+        output.setCount(insn.count);
+    }
+    
+    /*
+     * An extent ends where the next instruction does not start right after the previous one,
+     * which in practice joins the instructions of consecutive TBs. Counts are only stored if
+     * any instruction has one.
+     */
+    static void build_extents(CaptureResult::Builder result, const vector<capture_insn_t> & instructions) {
+        vector<size_t> starts;
+        bool has_counts = false;
+        for (size_t i = 0; i < instructions.size(); ++i) {
+            if (i == 0 || instructions[i].offset != instructions[i - 1].offset + instructions[i - 1].length) {
+                starts.push_back(i);
+            }
+            has_counts |= instructions[i].count != 0;
+        }
+        starts.push_back(instructions.size());
+        
+        auto output_extents = result.initExtents(starts.size() - 1);
+        for (size_t e = 0; e + 1 < starts.size(); ++e) {
+            size_t begin = starts[e], end = starts[e + 1];
+            output_extents[e].setOffset(instructions[begin].offset);
+            auto lengths = output_extents[e].initLengths(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                lengths[i - begin] = (uint8_t) instructions[i].length;
+            }
+            if (has_counts) {
+                auto counts = output_extents[e].initCounts(end - begin);
+                for (size_t i = begin; i < end; ++i) {
+                    counts.set(i - begin, instructions[i].count);
+                }
+            }
+        }
+    }
+    
+    bool write_version_1(
+        const char * file,
+        const vector<capture_insn_t> & instructions,
+        int64_t base_address,
+        string & digest,
+        const capture_details_t & details,
+        bool extents
+    ) {
+        int fd = open_file(file, true);
+        if (fd == -1) return false;
+        
+        ::capnp::MallocMessageBuilder message;
+        auto result = init_capture(message, base_address, digest);
+        if (extents) {
+            build_extents(result, instructions);
+        } else {
+            auto output_insns = result.initInstructions(instructions.size());
+            for (size_t i = 0; i < instructions.size(); ++i) {
+                set_instruction(output_insns[i], instructions[i]);
+            }
+        }
+        build_details(result, details);
+        writeMessageToFd(fd, message);
+        
+        close(fd);
+        return true;
+    }
+    
+    /*
+     * The merged list is written straight into the message: a first pass over the runs counts the
+     * distinct offsets, so that the list can be allocated, and a second one fills it
+     * Extents are built from the merged instructions instead, their number is only known afterwards
+     * Besides its instructions, the optional parts of old_file are merged in by read_details: edges,
+     * function starts, blocks, data ranges and modified offsets. Its timeline is only kept if details has none
+     */
+    bool merge_version_1(
+        const char * file,
+        const char * old_file,
+        const vector<capture_insn_t> & instructions,
+        int64_t base_address,
+        string & digest,
+        const capture_details_t & details,
+        size_t & n_merged,
+        bool extents
+    ) {
+        mapped_capture_t capture;
+        if (!capture.open(old_file)) return false;
+        
+        vector<insn_run_t> runs { flat_run(instructions) };
+        capture_details_t merged_details = details;
+        for (size_t m = 0; m < capture.messages.size(); ++m) {
+            message_runs(capture.get(m), runs);
+            read_details(capture.get(m), merged_details);
+        }
+        
+        ::capnp::MallocMessageBuilder message;
+        auto result = init_capture(message, base_address, digest);
+        if (extents) {
+            vector<capture_insn_t> merged;
+            merge_runs(runs, [&](const capture_insn_t & insn) {
+                merged.push_back(insn);
+            });
+            n_merged = merged.size();
+            build_extents(result, merged);
+        } else {
+            n_merged = 0;
+            merge_runs(runs, [&](const capture_insn_t &) {
+                ++n_merged;
+            });
+            
+            auto output_insns = result.initInstructions(n_merged);
+            size_t i = 0;
+            merge_runs(runs, [&](const capture_insn_t & insn) {
+                set_instruction(output_insns[i], insn);
+                ++i;
+            });
+        }
+        build_details(result, merged_details);
+        
+        int fd = open_file(file, true);
+        if (fd == -1) return false;
+        writeMessageToFd(fd, message);
+        close(fd);
+        return true;
+    }
 }
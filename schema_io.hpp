@@ -6,6 +6,8 @@
 #include <capnp/serialize.h>
 #include <bits/stdc++.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #ifdef _DEBUG_
     #define DEBUG_PRINT(msg) std::cerr << msg << std::endl;
@@ -13,6 +15,9 @@
     #define DEBUG_PRINT(msg) {}
 #endif
 
+// Digests are MD5 hex strings, unless prefixed with the name of another algorithm (digestAlgorithm field)
+#define XXH64_DIGEST_PREFIX "xxh64:"
+
 namespace std {
     // Return value represents whether the read is successful
     // NOTE: For all instructions input/output, it should EXCLUDE base_address
@@ -26,6 +31,13 @@ namespace std {
         map<int64_t, int8_t> & instructions,
         int64_t base_address
     );
+    // Same as above, also filling funcStarts (function starts EXCLUDE base_address, like instructions)
+    bool write_version_0(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t base_address,
+        const set<int64_t> & functions
+    );
     bool read_version_1(
         const char * file,
         map<int64_t, int8_t> & instructions,
@@ -38,6 +50,105 @@ namespace std {
         int64_t base_address,
         string & digest
     );
+    // Optional parts of a version 1 capture, all keyed by file offset
+    // Merging two captures sums the counts and unions everything else
+    struct capture_details_t {
+        map<int64_t, uint64_t> counts;
+        set<pair<int64_t, int64_t>> edges;
+        set<int64_t> functions;
+        // (offset, instructions, size) -> executed, merged with a logical or
+        map<tuple<int64_t, uint32_t, uint32_t>, bool> blocks;
+        // Code read as data, begin -> end, kept coalesced by add_data_range
+        map<int64_t, int64_t> data;
+        set<int64_t> modified;
+        // (offset, clock) in order of first execution, delta-encoded in the file
+        // Timelines of separate runs do not add up, merging keeps the first one found
+        vector<pair<int64_t, uint64_t>> timeline;
+        bool timeline_in_ns = false;
+    };
+    // Adds [begin, end) to ranges, joining it with the ranges it overlaps or touches
+    void add_data_range(
+        map<int64_t, int64_t> & ranges,
+        int64_t begin,
+        int64_t end
+    );
+    // Same as above, with the optional parts
+    bool read_version_1(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t & base_address,
+        string & digest,
+        capture_details_t & details
+    );
+    bool write_version_1(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t base_address,
+        string & digest,
+        const capture_details_t & details
+    );
+    // Flat representation used on the plugin's exit path, sorted by offset with one entry per offset
+    // count takes the place of capture_details_t::counts, which these functions ignore
+    struct capture_insn_t {
+        int64_t offset;
+        int8_t length;
+        uint64_t count;
+    };
+    bool read_version_1(
+        const char * file,
+        vector<capture_insn_t> & instructions,
+        int64_t & base_address,
+        string & digest,
+        capture_details_t & details
+    );
+    // extents: store the instructions as runs of contiguous instructions (CaptureResult.extents),
+    // about 20 times smaller, but unreadable by tools built before the field existed
+    bool write_version_1(
+        const char * file,
+        const vector<capture_insn_t> & instructions,
+        int64_t base_address,
+        string & digest,
+        const capture_details_t & details,
+        bool extents = false
+    );
+    bool write_version_0(
+        const char * file,
+        const vector<capture_insn_t> & instructions,
+        int64_t base_address,
+        const set<int64_t> & functions
+    );
+    // Only reads the digest and base address of the first message
+    bool read_header_version_1(
+        const char * file,
+        int64_t & base_address,
+        string & digest
+    );
+    // Writes instructions merged with the capture in old_file to file, in one linear pass over both
+    // old_file is mapped rather than loaded, its digest is expected to match (see read_header_version_1)
+    // n_merged is set to the number of instructions written
+    bool merge_version_1(
+        const char * file,
+        const char * old_file,
+        const vector<capture_insn_t> & instructions,
+        int64_t base_address,
+        string & digest,
+        const capture_details_t & details,
+        size_t & n_merged,
+        bool extents = false
+    );
+    // Merges other into instructions, both sorted
+    void merge_instructions(
+        vector<capture_insn_t> & instructions,
+        const vector<capture_insn_t> & other
+    );
+    // Appends one more message to file, creating it if needed
+    // read_version_1 merges all messages of a file, so this builds an incremental capture
+    bool append_version_1(
+        const char * file,
+        map<int64_t, int8_t> & instructions,
+        int64_t base_address,
+        string & digest
+    );
 }
 
 #endif